@@ -1,13 +1,18 @@
 #include "SchreinBluetoothManager.h"
 
-SchreinBluetoothManager::SchreinBluetoothManager(Stream &btStream, Mode mode) 
+SchreinBluetoothManager::SchreinBluetoothManager(Stream &btStream, Mode mode, SBM_LAYOUT) 
+#if SBM_CAPTURE_SIZE > 0
+    : linkCapture(btStream),
+      btStream(linkCapture),
+#else
     : btStream(btStream), 
+#endif
       currentMode(mode),
       connectionState(ConnectionState::DISCONNECTED),
       lastConnectionAttempt(0),
       lastSendAttempt(0),
-      lastModuleInfoRefresh(0),
-      modulePin("1234") {
+      modulePin("1234"),
+      lastModuleInfoRefresh(0) {
     resetAllRetryContexts();
 }
 
@@ -39,6 +44,11 @@ void SchreinBluetoothManager::enableRetry(bool enable) {
 void SchreinBluetoothManager::disableRetry() {
     enableRetry(false);
     resetAllRetryContexts();
+    
+    // Plus de tentative programmée : quitter RETRY_PENDING
+    if (connectionState == ConnectionState::RETRY_PENDING) {
+        dispatchConnectionEvent(ConnectionEvent::DISCONNECT_REQUESTED);
+    }
 }
 
 void SchreinBluetoothManager::begin() {
@@ -58,11 +68,16 @@ void SchreinBluetoothManager::begin() {
         sendATCommandWithRetry("AT+CMODE=0"); // Connection mode: specified address
     }
     
-    changeConnectionState(ConnectionState::DISCONNECTED);
+    // Module réinitialisé : aucune tentative en cours ne survit
+    dispatchConnectionEvent(ConnectionEvent::DISCONNECT_REQUESTED);
+    resetAllRetryContexts();
 }
 
 void SchreinBluetoothManager::end() {
     disconnect();
+    resetAllChannels();
+    cancelBulkTransfer();
+    bulkReceiveContext.reset();
 }
 
 bool SchreinBluetoothManager::connect(String deviceAddress) {
@@ -107,21 +122,31 @@ bool SchreinBluetoothManager::forceConnect(String deviceAddress, bool skipRetry)
         return false;
     }
     
-    changeConnectionState(ConnectionState::CONNECTING);
+    if (!dispatchConnectionEvent(ConnectionEvent::CONNECT_REQUESTED)) {
+        if (onErrorCallback) onErrorCallback("Connection already in progress");
+        return false;
+    }
     lastConnectionAttempt = millis();
     
     // Formater l'adresse (remplacer les : par des ,)
     String formattedAddress = connectedDeviceAddress;
     formattedAddress.replace(":", ",");
     
-    // Commande de connexion
+    // Commande de connexion (la réponse "CONNECTED" est consommée ici)
     String command = "AT+CONN=" + formattedAddress;
-    return sendATCommandWithRetry(command, "CONNECTED", 10000);
+    if (sendATCommandWithRetry(command, "CONNECTED", 10000)) {
+        dispatchConnectionEvent(ConnectionEvent::LINK_UP);
+        return true;
+    }
+    
+    dispatchConnectionEvent(ConnectionEvent::FAILURE);
+    return false;
 }
 
 void SchreinBluetoothManager::disconnect() {
     sendATCommandWithRetry("AT+DISC", "DISC OK", 2000);
-    changeConnectionState(ConnectionState::DISCONNECTED);
+    dispatchConnectionEvent(ConnectionEvent::DISCONNECT_REQUESTED);
+    activePeer = -1;
     connectedDeviceAddress = "";
     resetAllRetryContexts();
 }
@@ -197,6 +222,9 @@ String SchreinBluetoothManager::getRetryStatus() const {
 }
 
 void SchreinBluetoothManager::loop() {
+    // Réveiller le module si du travail est dû
+    updatePowerState(true);
+    
     // Traitement des retry en cours
     processConnectionRetry();
     processSendRetry();
@@ -210,44 +238,455 @@ void SchreinBluetoothManager::loop() {
         if (retryConfig.enableConnectionRetry) {
             startConnectionRetry(connectedDeviceAddress);
         } else {
-            changeConnectionState(ConnectionState::ERROR);
+            dispatchConnectionEvent(ConnectionEvent::FAILURE);
             if (onErrorCallback) onErrorCallback("Connection timeout");
         }
     }
     
-    // Traiter les commandes Bluetooth
+    // Poignée de main de la session sécurisée
+    processSecureSession();
+    
+    // Vider la file hors connexion avant tout nouvel envoi
+    processOfflineQueue();
+    
+    // Délivrer les messages mis de côté pour le pair connecté
+    processPeerQueue();
+    
+    // Émettre les trames en attente sur les canaux logiques
+    processChannelScheduler();
+    
+    // Faire avancer le transfert en masse
+    processBulkTransfer();
+    
+    // Traiter les lignes reçues : URC du module et données utilisateur,
+    // découpées à SBM_MAX_LINE_LENGTH par readATResponse()
     processBluetoothCommands();
     
-    // Traiter les données utilisateur
-    processIncomingData();
+    // Endormir le module si rien n'est attendu avant longtemps
+    updatePowerState(false);
 }
 
 bool SchreinBluetoothManager::sendRawData(const String &data) {
+    if (shouldStoreOffline()) {
+        return storeOffline((const uint8_t *)data.c_str(), data.length());
+    }
+    
     if (!isConnected()) {
         if (onErrorCallback) onErrorCallback("Not connected");
         return false;
     }
     
+#if SBM_ENABLE_METRICS
+    unsigned long startMicros = micros();
+#endif
+    
+    wakeModule();
     btStream.print(data);
     btStream.println();
     lastSendAttempt = millis();
     
+    if (activePeer >= 0) {
+        peerSessions[activePeer].txSequence++;
+        peerSessions[activePeer].bytesSent += data.length() + 2;
+    }
+    
+#if SBM_ENABLE_METRICS
+    recordMetrics(metrics.sendRawData, startMicros, data.length());
+#endif
+    return true;
+}
+
+bool SchreinBluetoothManager::sendRawData(const uint8_t *data, size_t length) {
+    if (shouldStoreOffline()) {
+        return storeOffline(data, length);
+    }
+    
+    if (!isConnected()) {
+        if (onErrorCallback) onErrorCallback("Not connected");
+        return false;
+    }
+    
+#if SBM_ENABLE_METRICS
+    unsigned long startMicros = micros();
+#endif
+    
+    transmitRawLine(data, length);
+    
+#if SBM_ENABLE_METRICS
+    recordMetrics(metrics.sendRawBytes, startMicros, length);
+#endif
     return true;
 }
 
 bool SchreinBluetoothManager::sendRawDataWithRetry(const String &data) {
+    if (shouldStoreOffline()) {
+        return storeOffline((const uint8_t *)data.c_str(), data.length());
+    }
+    
     if (!isConnected()) {
         if (onErrorCallback) onErrorCallback("Not connected");
         return false;
     }
     
     if (retryConfig.enableSendRetry) {
+#if SBM_ENABLE_METRICS
+        sendRetryQueuedMicros = micros();
+#endif
         return startSendRetry(data);
     } else {
         return sendRawData(data);
     }
 }
 
+bool SchreinBluetoothManager::enableSecureSession(const uint8_t *key, bool requireSecure) {
+    // Un aléa prévisible rendrait les clés de session rejouables
+    if (!randomSource) {
+        if (onErrorCallback) onErrorCallback("Secure session requires a random source");
+        return false;
+    }
+    
+    memcpy(presharedKey, key, SchreinChaChaPoly::KEY_SIZE);
+    secureSession.resetSession();
+    secureSession.enabled = true;
+    secureSession.requireSecure = requireSecure;
+    secureSession.framesRejected = 0;
+    startSecureHandshake();
+    return true;
+}
+
+void SchreinBluetoothManager::disableSecureSession() {
+    secureSession.resetSession();
+    secureSession.enabled = false;
+    secureSession.requireSecure = false;
+    memset(presharedKey, 0, sizeof(presharedKey));
+}
+
+bool SchreinBluetoothManager::isSecureSessionEstablished() const {
+    return secureSession.enabled && secureSession.established;
+}
+
+bool SchreinBluetoothManager::sendSecure(uint8_t *data, size_t length) {
+    if (!isConnected()) {
+        if (onErrorCallback) onErrorCallback("Not connected");
+        return false;
+    }
+    
+    if (!isSecureSessionEstablished()) {
+        if (onErrorCallback) onErrorCallback("Secure session not established");
+        return false;
+    }
+    
+    if (length > SBM_SECURE_MAX_PAYLOAD) {
+        if (onErrorCallback) onErrorCallback("Secure payload too large");
+        return false;
+    }
+    
+    return transmitSecureFrame(data, length);
+}
+
+bool SchreinBluetoothManager::sendSecure(const String &data) {
+    if (data.length() > SBM_SECURE_MAX_PAYLOAD) {
+        if (onErrorCallback) onErrorCallback("Secure payload too large");
+        return false;
+    }
+    
+    // Copie unique dans le tampon de trame, chiffrée ensuite en place
+    memcpy(secureBuffer + 4, data.c_str(), data.length());
+    return sendSecure(secureBuffer + 4, data.length());
+}
+
+unsigned long SchreinBluetoothManager::getSecureRejectedFrames() const {
+    return secureSession.framesRejected;
+}
+
+void SchreinBluetoothManager::setRandomSource(void (*source)(uint8_t *buffer, size_t length)) {
+    randomSource = source;
+    if (!randomSource && secureSession.enabled) {
+        disableSecureSession();
+        if (onErrorCallback) onErrorCallback("Secure session disabled: no random source");
+    }
+}
+
+void SchreinBluetoothManager::setOfflineQueue(SchreinOfflineQueue *queue) {
+    offlineQueue = queue;
+}
+
+uint32_t SchreinBluetoothManager::getOfflinePendingCount() const {
+    return offlineQueue ? offlineQueue->getPendingCount() : 0;
+}
+
+bool SchreinBluetoothManager::sendToPeer(const String &address, const String &data) {
+    if (currentMode != Mode::SERVER) {
+        if (onErrorCallback) onErrorCallback("Not in server mode");
+        return false;
+    }
+    
+    uint8_t bytes[6];
+    if (!macToBytes(address, bytes)) {
+        if (onErrorCallback) onErrorCallback("Invalid peer address");
+        return false;
+    }
+    
+    int8_t index = acquirePeer(bytes);
+    if (index < 0) {
+        if (onErrorCallback) onErrorCallback("Peer table full");
+        return false;
+    }
+    PeerSession &peer = peerSessions[index];
+    
+    // Pair connecté et rien en attente : envoi direct, sinon mise en file
+    if (index == activePeer && isConnected() && peer.count == 0) {
+        return sendRawData(data);
+    }
+    
+    if (peer.count >= SBM_PEER_QUEUE_SIZE) {
+        peer.framesDropped++;
+        if (onErrorCallback) onErrorCallback("Peer queue full: " + address);
+        return false;
+    }
+    
+    peer.queue[(peer.head + peer.count) % SBM_PEER_QUEUE_SIZE] = data;
+    peer.count++;
+    return true;
+}
+
+bool SchreinBluetoothManager::setActivePeer(const String &address) {
+    if (currentMode != Mode::SERVER || !isConnected()) return false;
+    
+    activatePeer(address);
+    return activePeer >= 0;
+}
+
+String SchreinBluetoothManager::getActivePeerAddress() const {
+    if (activePeer < 0) return "";
+    return macToString(peerSessions[activePeer].address);
+}
+
+const SchreinBluetoothManager::PeerSession *SchreinBluetoothManager::getPeerSession(const String &address) const {
+    uint8_t bytes[6];
+    if (!macToBytes(address, bytes)) return nullptr;
+    
+    int8_t index = findPeer(bytes);
+    return index >= 0 ? &peerSessions[index] : nullptr;
+}
+
+uint8_t SchreinBluetoothManager::getPeerCount() const {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < SBM_MAX_PEERS; i++) {
+        if (peerSessions[i].inUse) count++;
+    }
+    return count;
+}
+
+unsigned long SchreinBluetoothManager::getEvictedPeerFrames() const {
+    return evictedPeerFrames;
+}
+
+void SchreinBluetoothManager::forgetPeer(const String &address) {
+    uint8_t bytes[6];
+    if (!macToBytes(address, bytes)) return;
+    
+    int8_t index = findPeer(bytes);
+    if (index < 0) return;
+    
+    peerSessions[index].reset();
+    if (index == activePeer) activePeer = -1;
+}
+
+void SchreinBluetoothManager::onPeerConnect(void (*callback)(String address, bool resumed)) {
+    onPeerConnectCallback = callback;
+}
+
+bool SchreinBluetoothManager::openChannel(uint8_t channel, uint8_t priority) {
+    if (channel >= SBM_MAX_CHANNELS || priority == 0) return false;
+    
+    Channel &ch = channels[channel];
+    ch.isOpen = true;
+    ch.priority = priority;
+    ch.currentWeight = 0;
+    return true;
+}
+
+void SchreinBluetoothManager::closeChannel(uint8_t channel) {
+    if (channel >= SBM_MAX_CHANNELS) return;
+    channels[channel].reset();
+}
+
+bool SchreinBluetoothManager::sendOnChannel(uint8_t channel, const String &data) {
+    if (channel >= SBM_MAX_CHANNELS || !channels[channel].isOpen) {
+        if (onErrorCallback) onErrorCallback("Channel not open");
+        return false;
+    }
+    
+    Channel &ch = channels[channel];
+    if (ch.count >= SBM_CHANNEL_QUEUE_SIZE) {
+        ch.framesDropped++;
+        if (onErrorCallback) onErrorCallback("Channel queue full: " + String(channel));
+        return false;
+    }
+    
+    uint8_t tail = (ch.head + ch.count) % SBM_CHANNEL_QUEUE_SIZE;
+    ch.queue[tail] = data;
+    ch.count++;
+    return true;
+}
+
+uint8_t SchreinBluetoothManager::getChannelQueueLength(uint8_t channel) const {
+    if (channel >= SBM_MAX_CHANNELS) return 0;
+    return channels[channel].count;
+}
+
+unsigned long SchreinBluetoothManager::getChannelDroppedFrames(uint8_t channel) const {
+    if (channel >= SBM_MAX_CHANNELS) return 0;
+    return channels[channel].framesDropped;
+}
+
+void SchreinBluetoothManager::onChannelData(uint8_t channel, void (*callback)(String data)) {
+    if (channel >= SBM_MAX_CHANNELS) return;
+    channels[channel].onDataCallback = callback;
+}
+
+bool SchreinBluetoothManager::startBulkTransfer(uint32_t totalSize, size_t (*reader)(uint32_t offset, uint8_t *buffer, size_t length)) {
+    if (reader == nullptr || totalSize == 0) return false;
+    
+    if (bulkTransferContext.isActive) {
+        if (onErrorCallback) onErrorCallback("Bulk transfer already active");
+        return false;
+    }
+    
+    bulkTransferContext.reset();
+    bulkTransferContext.isActive = true;
+    bulkTransferContext.needsHandshake = true;
+    bulkTransferContext.totalSize = totalSize;
+    bulkTransferContext.reader = reader;
+    return true;
+}
+
+void SchreinBluetoothManager::cancelBulkTransfer() {
+    bulkTransferContext.reset();
+}
+
+bool SchreinBluetoothManager::isBulkTransferActive() const {
+    return bulkTransferContext.isActive;
+}
+
+uint32_t SchreinBluetoothManager::getBulkTransferOffset() const {
+    return bulkTransferContext.ackedOffset;
+}
+
+void SchreinBluetoothManager::onBulkTransferComplete(void (*callback)(bool success, uint32_t totalSize)) {
+    onBulkTransferCompleteCallback = callback;
+}
+
+void SchreinBluetoothManager::onBulkDataReceived(bool (*writer)(uint32_t offset, const uint8_t *data, size_t length)) {
+    onBulkDataReceivedCallback = writer;
+}
+
+void SchreinBluetoothManager::onBulkReceiveComplete(void (*callback)(bool success, uint32_t totalSize)) {
+    onBulkReceiveCompleteCallback = callback;
+}
+
+void SchreinBluetoothManager::configureLowPower(const LowPowerConfig &config) {
+    lowPowerConfig = config;
+    nextBurstTime = millis() + config.burstInterval;
+    
+    if (!config.enabled && !moduleAwake) {
+        setModulePower(true);
+    }
+}
+
+SchreinBluetoothManager::LowPowerConfig SchreinBluetoothManager::getLowPowerConfig() const {
+    return lowPowerConfig;
+}
+
+unsigned long SchreinBluetoothManager::getIdleDuration() {
+    if (btStream.available()) return 0;
+    
+    unsigned long now = millis();
+    unsigned long idle = ULONG_MAX;
+    
+    // Retry programmés
+    const RetryContext *contexts[] = { &connectionRetryContext, &sendRetryContext, &atRetryContext };
+    for (uint8_t i = 0; i < 3; i++) {
+        if (contexts[i]->isRetrying) {
+            idle = min(idle, remainingUntil(contexts[i]->nextRetryTime, now));
+        }
+    }
+    
+    // Timeout de connexion
+    if (connectionState == ConnectionState::CONNECTING && !connectionRetryContext.isRetrying) {
+        idle = min(idle, remainingUntil(lastConnectionAttempt + CONNECTION_TIMEOUT + 1, now));
+    }
+    
+    // Empreinte du transfert en masse en cours de calcul (connecté ou non)
+    if (bulkTransferContext.isActive && bulkTransferContext.crcOffset < bulkTransferContext.totalSize) {
+        return 0;
+    }
+    
+    if (isConnected()) {
+        // File hors connexion à vider
+        if (offlineQueue && !offlineQueue->isEmpty()) return 0;
+        
+        // Messages mis de côté pour le pair qui vient de se connecter
+        if (activePeer >= 0 && peerSessions[activePeer].count > 0) return 0;
+        
+        // Poignée de main sécurisée : hello à émettre, ou à réémettre
+        const SecureSessionContext &session = secureSession;
+        if (session.enabled && !session.established) {
+            if (session.needsHello) return 0;
+            idle = min(idle, remainingUntil(session.lastHelloTime + SBM_SECURE_HANDSHAKE_TIMEOUT + 1, now));
+        }
+        
+        // Trames en attente : tout de suite, ou à la prochaine rafale
+        for (uint8_t i = 0; i < SBM_MAX_CHANNELS; i++) {
+            if (channels[i].count > 0) {
+                bool burstMode = lowPowerConfig.enabled && lowPowerConfig.burstInterval > 0;
+                idle = min(idle, burstMode ? remainingUntil(nextBurstTime, now) : 0UL);
+                break;
+            }
+        }
+        
+        // Transfert en masse : bloc à émettre, ou échéance d'ACK
+        const BulkTransferContext &tx = bulkTransferContext;
+        if (tx.isActive) {
+            bool canSend = !tx.awaitingHandshake && tx.nextOffset < tx.totalSize &&
+                tx.nextOffset - tx.ackedOffset < (uint32_t)SBM_BULK_WINDOW * SBM_BULK_CHUNK_SIZE;
+            if (tx.needsHandshake || canSend || (tx.ackedOffset >= tx.totalSize && !tx.endSent)) {
+                idle = 0;
+            } else {
+                idle = min(idle, remainingUntil(tx.lastActivityTime + SBM_BULK_ACK_TIMEOUT + 1, now));
+            }
+        }
+    }
+    
+    return idle;
+}
+
+bool SchreinBluetoothManager::isModuleAwake() const {
+    return moduleAwake;
+}
+
+SchreinBluetoothManager::PowerStats SchreinBluetoothManager::getPowerStats() const {
+    // Inclure la période en cours
+    PowerStats stats = powerStats;
+    unsigned long elapsed = millis() - lastPowerTransition;
+    if (moduleAwake) {
+        stats.awakeTime += elapsed;
+    } else {
+        stats.sleepTime += elapsed;
+    }
+    return stats;
+}
+
+void SchreinBluetoothManager::resetPowerStats() {
+    powerStats = PowerStats();
+    lastPowerTransition = millis();
+}
+
+void SchreinBluetoothManager::onModulePower(void (*callback)(bool awake)) {
+    onModulePowerCallback = callback;
+}
+
 bool SchreinBluetoothManager::setPin(String newPin) {
     if (newPin.length() != 4) return false;
     
@@ -286,8 +725,7 @@ String SchreinBluetoothManager::getModuleName(bool forceRefresh) {
 }
 
 bool SchreinBluetoothManager::refreshModuleInfo(unsigned long timeout) {
-    // Sauvegarder l'état actuel
-    ConnectionState previousState = connectionState;
+    wakeModule();
     
     // Entrer en mode commande AT
     btStream.println("AT");
@@ -295,40 +733,141 @@ bool SchreinBluetoothManager::refreshModuleInfo(unsigned long timeout) {
         return false;
     }
     
-    // Récupérer l'adresse MAC
+    // Récupérer l'adresse MAC (le reste de la ligne suit le préfixe)
     btStream.println("AT+ADDR?");
-    String response = waitForResponse("+ADDR:", timeout);
-    if (response != "") {
-        moduleAddress = parseMacAddress(response);
+    if (waitForResponse("+ADDR:", timeout)) {
+        moduleAddress = parseMacAddress(readATResponse(timeout));
     }
     
     // Récupérer le nom
     btStream.println("AT+NAME?");
-    response = waitForResponse("+NAME:", timeout);
-    if (response != "") {
-        moduleName = response.substring(response.indexOf(":") + 1);
-        moduleName.trim();
+    if (waitForResponse("+NAME:", timeout)) {
+        moduleName = readATResponse(timeout);
     }
     
     // Récupérer le PIN
     btStream.println("AT+PSWD?");
-    response = waitForResponse("+PSWD:", timeout);
-    if (response != "") {
-        modulePin = response.substring(response.indexOf(":") + 1);
-        modulePin.trim();
+    if (waitForResponse("+PSWD:", timeout)) {
+        modulePin = readATResponse(timeout);
     }
     
     // Quitter le mode AT
     btStream.println("AT+RESET");
     delay(1000);
     
-    // Restaurer l'état précédent
-    changeConnectionState(previousState);
     lastModuleInfoRefresh = millis();
     
     return moduleAddress != "";
 }
 
+bool SchreinBluetoothManager::startCapture() {
+#if SBM_CAPTURE_SIZE > 0
+    linkCapture.start();
+    linkCapture.recordEvent((uint8_t)connectionState);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SchreinBluetoothManager::stopCapture() {
+#if SBM_CAPTURE_SIZE > 0
+    linkCapture.stop();
+#endif
+}
+
+size_t SchreinBluetoothManager::getCaptureSize() const {
+#if SBM_CAPTURE_SIZE > 0
+    return linkCapture.size();
+#else
+    return 0;
+#endif
+}
+
+void SchreinBluetoothManager::dumpCapture(Print &output) const {
+#if SBM_CAPTURE_SIZE > 0
+    linkCapture.dump(output);
+#else
+    (void)output;
+#endif
+}
+
+#if SBM_ENABLE_METRICS
+const SchreinBluetoothManager::LinkMetrics &SchreinBluetoothManager::getMetrics() const {
+    return metrics;
+}
+
+void SchreinBluetoothManager::resetMetrics() {
+    metrics = LinkMetrics();
+}
+
+void SchreinBluetoothManager::printMetricsJson(Print &output) const {
+    output.print("{");
+    printPathMetricsJson(output, "sendRawData", metrics.sendRawData);
+    output.print(",");
+    printPathMetricsJson(output, "sendRawBytes", metrics.sendRawBytes);
+    output.print(",");
+    printPathMetricsJson(output, "sendRawDataWithRetry", metrics.sendWithRetry);
+    output.print(",");
+    printPathMetricsJson(output, "receive", metrics.receive);
+    output.print(",");
+    printPathMetricsJson(output, "sendATCommand", metrics.atCommand);
+    output.print(",");
+    printPathMetricsJson(output, "secureSend", metrics.secureSend);
+    output.print(",");
+    printPathMetricsJson(output, "secureReceive", metrics.secureReceive);
+    
+    // Surcoût fixe d'une trame chiffrée : binaire, puis en-tête "!S:" et fin de ligne
+    output.print(",\"secure_overhead\":{\"auth_bytes\":");
+    output.print(String(SBM_SECURE_OVERHEAD));
+    output.print(",\"wire_bytes\":");
+    output.print(String(SBM_SECURE_OVERHEAD * 2 + 5));
+    output.print(",\"hex_expansion\":2,\"rejected_frames\":");
+    output.print(String(secureSession.framesRejected));
+    output.println("}}");
+}
+#endif
+
+bool SchreinBluetoothManager::checkInvariants() const {
+    if (connectionState > ConnectionState::RETRY_PENDING) return false;
+    
+    // Le dernier événement accepté doit avoir mené à l'état courant
+    for (uint8_t i = transitionTraceCount; i > 0; i--) {
+        const TransitionTraceEntry &entry = transitionTrace[(transitionTraceHead + i - 1) % SBM_TRACE_SIZE];
+        if (entry.accepted) {
+            if (entry.toState != (uint8_t)connectionState) return false;
+            break;
+        }
+    }
+    
+    // RETRY_PENDING si et seulement si un retry de connexion est programmé
+    if (connectionRetryContext.isRetrying != (connectionState == ConnectionState::RETRY_PENDING)) return false;
+    
+    for (uint8_t i = 0; i < SBM_MAX_CHANNELS; i++) {
+        const Channel &ch = channels[i];
+        if (ch.count > SBM_CHANNEL_QUEUE_SIZE || ch.head >= SBM_CHANNEL_QUEUE_SIZE) return false;
+        if (!ch.isOpen && ch.count > 0) return false;
+    }
+    
+    if (activePeer >= SBM_MAX_PEERS || (activePeer >= 0 && !peerSessions[activePeer].inUse)) return false;
+    for (uint8_t i = 0; i < SBM_MAX_PEERS; i++) {
+        if (peerSessions[i].count > SBM_PEER_QUEUE_SIZE) return false;
+    }
+    
+    const BulkTransferContext &tx = bulkTransferContext;
+    if (tx.isActive) {
+        if (tx.ackedOffset > tx.nextOffset || tx.nextOffset > tx.totalSize) return false;
+        if (tx.crcOffset > tx.totalSize) return false;
+        if (tx.crcOffset < tx.totalSize && tx.nextOffset > 0) return false;
+        if (tx.nextOffset - tx.ackedOffset > (uint32_t)SBM_BULK_WINDOW * SBM_BULK_CHUNK_SIZE) return false;
+    }
+    
+    const BulkReceiveContext &rx = bulkReceiveContext;
+    if (rx.isActive && rx.expectedOffset > rx.totalSize) return false;
+    
+    return true;
+}
+
 void SchreinBluetoothManager::onConnect(void (*callback)()) {
     onConnectCallback = callback;
 }
@@ -357,53 +896,176 @@ void SchreinBluetoothManager::onRetrySuccess(void (*callback)(uint8_t totalAttem
     onRetrySuccessCallback = callback;
 }
 
-void SchreinBluetoothManager::changeConnectionState(ConnectionState newState) {
-    if (connectionState != newState) {
-        connectionState = newState;
-        
-        // Appeler les callbacks
-        if (newState == ConnectionState::CONNECTED && onConnectCallback) {
-            onConnectCallback();
-        } else if (newState == ConnectionState::DISCONNECTED && onDisconnectCallback) {
-            onDisconnectCallback();
-        }
-    }
-}
+// Table de transitions : (état, événement) -> état, sous garde éventuelle.
+// Toute paire absente est rejetée et laisse l'état inchangé.
+const SchreinBluetoothManager::StateTransition SchreinBluetoothManager::stateTransitionTable[] = {
+    { ConnectionState::DISCONNECTED,  ConnectionEvent::CONNECT_REQUESTED,    ConnectionState::CONNECTING,    &SchreinBluetoothManager::guardClientMode },
+    { ConnectionState::DISCONNECTED,  ConnectionEvent::RETRY_SCHEDULED,      ConnectionState::RETRY_PENDING, &SchreinBluetoothManager::guardConnectionRetryEnabled },
+    { ConnectionState::DISCONNECTED,  ConnectionEvent::LINK_UP,              ConnectionState::CONNECTED,     nullptr },
+    { ConnectionState::DISCONNECTED,  ConnectionEvent::FAILURE,              ConnectionState::ERROR,         nullptr },
+    { ConnectionState::DISCONNECTED,  ConnectionEvent::LINK_DOWN,            ConnectionState::DISCONNECTED,  nullptr },
+    { ConnectionState::DISCONNECTED,  ConnectionEvent::DISCONNECT_REQUESTED, ConnectionState::DISCONNECTED,  nullptr },
+    
+    { ConnectionState::CONNECTING,    ConnectionEvent::LINK_UP,              ConnectionState::CONNECTED,     nullptr },
+    { ConnectionState::CONNECTING,    ConnectionEvent::LINK_DOWN,            ConnectionState::DISCONNECTED,  nullptr },
+    { ConnectionState::CONNECTING,    ConnectionEvent::RETRY_SCHEDULED,      ConnectionState::RETRY_PENDING, &SchreinBluetoothManager::guardConnectionRetryEnabled },
+    { ConnectionState::CONNECTING,    ConnectionEvent::FAILURE,              ConnectionState::ERROR,         nullptr },
+    { ConnectionState::CONNECTING,    ConnectionEvent::DISCONNECT_REQUESTED, ConnectionState::DISCONNECTED,  nullptr },
+    
+    { ConnectionState::CONNECTED,     ConnectionEvent::LINK_DOWN,            ConnectionState::DISCONNECTED,  nullptr },
+    { ConnectionState::CONNECTED,     ConnectionEvent::FAILURE,              ConnectionState::ERROR,         nullptr },
+    { ConnectionState::CONNECTED,     ConnectionEvent::DISCONNECT_REQUESTED, ConnectionState::DISCONNECTED,  nullptr },
+    
+    { ConnectionState::ERROR,         ConnectionEvent::CONNECT_REQUESTED,    ConnectionState::CONNECTING,    &SchreinBluetoothManager::guardClientMode },
+    { ConnectionState::ERROR,         ConnectionEvent::RETRY_SCHEDULED,      ConnectionState::RETRY_PENDING, &SchreinBluetoothManager::guardConnectionRetryEnabled },
+    { ConnectionState::ERROR,         ConnectionEvent::LINK_UP,              ConnectionState::CONNECTED,     nullptr },
+    { ConnectionState::ERROR,         ConnectionEvent::LINK_DOWN,            ConnectionState::DISCONNECTED,  nullptr },
+    { ConnectionState::ERROR,         ConnectionEvent::DISCONNECT_REQUESTED, ConnectionState::DISCONNECTED,  nullptr },
+    
+    { ConnectionState::RETRY_PENDING, ConnectionEvent::RETRY_SCHEDULED,      ConnectionState::RETRY_PENDING, &SchreinBluetoothManager::guardConnectionRetryEnabled },
+    { ConnectionState::RETRY_PENDING, ConnectionEvent::RETRY_DUE,            ConnectionState::CONNECTING,    nullptr },
+    { ConnectionState::RETRY_PENDING, ConnectionEvent::LINK_UP,              ConnectionState::CONNECTED,     nullptr },
+    { ConnectionState::RETRY_PENDING, ConnectionEvent::LINK_DOWN,            ConnectionState::DISCONNECTED,  nullptr },
+    { ConnectionState::RETRY_PENDING, ConnectionEvent::FAILURE,              ConnectionState::ERROR,         nullptr },
+    { ConnectionState::RETRY_PENDING, ConnectionEvent::DISCONNECT_REQUESTED, ConnectionState::DISCONNECTED,  nullptr },
+};
 
-String SchreinBluetoothManager::readATResponse(unsigned long timeout) {
-    String response = "";
-    unsigned long startTime = millis();
+bool SchreinBluetoothManager::dispatchConnectionEvent(ConnectionEvent event) {
+    ConnectionState fromState = connectionState;
+    const uint8_t tableSize = sizeof(stateTransitionTable) / sizeof(stateTransitionTable[0]);
     
-    while (millis() - startTime < timeout) {
-        if (btStream.available()) {
-            char c = btStream.read();
-            response += c;
-            
-            if (response.endsWith("\r\n")) {
-                response.trim();
-                break;
-            }
-        }
+    for (uint8_t i = 0; i < tableSize; i++) {
+        const StateTransition &transition = stateTransitionTable[i];
+        if (transition.from != fromState || transition.event != event) continue;
+        
+        if (transition.guard && !(this->*transition.guard)()) break;
+        
+        recordTransition(event, fromState, transition.to, true);
+        changeConnectionState(transition.to);
+        return true;
     }
     
-    return response;
+    recordTransition(event, fromState, fromState, false);
+    return false;
 }
 
-bool SchreinBluetoothManager::waitForResponse(String expectedResponse, unsigned long timeout) {
-    unsigned long startTime = millis();
+bool SchreinBluetoothManager::guardClientMode() const {
+    return currentMode == Mode::CLIENT;
+}
+
+bool SchreinBluetoothManager::guardConnectionRetryEnabled() const {
+    return retryConfig.enableConnectionRetry;
+}
+
+void SchreinBluetoothManager::recordTransition(ConnectionEvent event, ConnectionState fromState,
+                                               ConnectionState toState, bool accepted) {
+    uint8_t index = (transitionTraceHead + transitionTraceCount) % SBM_TRACE_SIZE;
+    if (transitionTraceCount < SBM_TRACE_SIZE) {
+        transitionTraceCount++;
+    } else {
+        transitionTraceHead = (transitionTraceHead + 1) % SBM_TRACE_SIZE;
+    }
+    
+    TransitionTraceEntry &entry = transitionTrace[index];
+    entry.timestamp = millis();
+    entry.event = (uint8_t)event;
+    entry.fromState = (uint8_t)fromState;
+    entry.toState = (uint8_t)toState;
+    entry.accepted = accepted;
+}
+
+uint8_t SchreinBluetoothManager::getTransitionTraceLength() const {
+    return transitionTraceCount;
+}
+
+bool SchreinBluetoothManager::getTransitionTraceEntry(uint8_t index, TransitionTraceEntry &entry) const {
+    if (index >= transitionTraceCount) return false;
+    entry = transitionTrace[(transitionTraceHead + index) % SBM_TRACE_SIZE];
+    return true;
+}
+
+void SchreinBluetoothManager::dumpTransitionTrace(Print &output) const {
+    // 6 octets par entrée, du plus ancien au plus récent :
+    // horodatage (uint32 LE), événement | accepté << 7, départ << 4 | arrivée
+    for (uint8_t i = 0; i < transitionTraceCount; i++) {
+        const TransitionTraceEntry &entry = transitionTrace[(transitionTraceHead + i) % SBM_TRACE_SIZE];
+        uint8_t record[6] = {
+            (uint8_t)entry.timestamp, (uint8_t)(entry.timestamp >> 8),
+            (uint8_t)(entry.timestamp >> 16), (uint8_t)(entry.timestamp >> 24),
+            (uint8_t)(entry.event | (entry.accepted ? 0x80 : 0)),
+            (uint8_t)((entry.fromState << 4) | (entry.toState & 0x0F))
+        };
+        output.write(record, sizeof(record));
+    }
+}
+
+void SchreinBluetoothManager::clearTransitionTrace() {
+    transitionTraceHead = 0;
+    transitionTraceCount = 0;
+}
+
+void SchreinBluetoothManager::changeConnectionState(ConnectionState newState) {
+    if (connectionState != newState) {
+        connectionState = newState;
+        
+#if SBM_CAPTURE_SIZE > 0
+        linkCapture.recordEvent((uint8_t)newState);
+#endif
+        
+        // Nouvelle liaison : renégocier les clés de session
+        if (newState == ConnectionState::CONNECTED && secureSession.enabled) {
+            startSecureHandshake();
+        }
+        
+        // Reprendre le transfert en masse à l'offset confirmé par le pair
+        if (newState == ConnectionState::CONNECTED && bulkTransferContext.isActive) {
+            bulkTransferContext.needsHandshake = true;
+            bulkTransferContext.awaitingHandshake = false;
+        }
+        
+        // Appeler les callbacks
+        if (newState == ConnectionState::CONNECTED && onConnectCallback) {
+            onConnectCallback();
+        } else if (newState == ConnectionState::DISCONNECTED && onDisconnectCallback) {
+            onDisconnectCallback();
+        }
+    }
+}
+
+String SchreinBluetoothManager::readATResponse(unsigned long timeout) {
     String response = "";
+    unsigned long startTime = millis();
     
     while (millis() - startTime < timeout) {
         if (btStream.available()) {
             char c = btStream.read();
             response += c;
             
-            if (response.indexOf(expectedResponse) >= 0) {
+            // Ligne terminée, ou trop longue : la couper pour borner la mémoire
+            if (c == '\n' || response.length() >= SBM_MAX_LINE_LENGTH) {
+                response.trim();
+                break;
+            }
+        }
+    }
+    
+    return response;
+}
+
+bool SchreinBluetoothManager::waitForResponse(String expectedResponse, unsigned long timeout) {
+    unsigned long startTime = millis();
+    String response = "";
+    
+    while (millis() - startTime < timeout) {
+        if (btStream.available()) {
+            appendToMatchWindow(response, btStream.read(), expectedResponse.length());
+            
+            if (response.endsWith(expectedResponse)) {
                 return true;
             }
             
             // Vérifier les erreurs
-            if (response.indexOf("ERROR") >= 0 || response.indexOf("FAIL") >= 0) {
+            if (response.endsWith("ERROR") || response.endsWith("FAIL")) {
                 return false;
             }
         }
@@ -412,6 +1074,21 @@ bool SchreinBluetoothManager::waitForResponse(String expectedResponse, unsigned
     return false;
 }
 
+void SchreinBluetoothManager::appendToMatchWindow(String &window, char c, unsigned int keep) {
+    // Les réponses attendues tiennent sur une ligne : repartir à zéro à chaque
+    // fin de ligne, et ne garder que la fin utile d'une ligne trop longue.
+    // Tester endsWith() à chaque octet reste ainsi en O(longueur attendue).
+    if (c == '\n') {
+        window = "";
+        return;
+    }
+    
+    window += c;
+    if (window.length() >= SBM_MAX_LINE_LENGTH) {
+        window.remove(0, window.length() - (keep < 5 ? 5 : keep));
+    }
+}
+
 String SchreinBluetoothManager::parseMacAddress(String rawResponse) {
     String rawMac = rawResponse;
     
@@ -420,12 +1097,30 @@ String SchreinBluetoothManager::parseMacAddress(String rawResponse) {
     }
     rawMac.trim();
     
-    // Supprimer les deux-points existants
-    String cleanMac;
+    // Compter les segments : le HC-05 répond NAP:UAP:LAP sans zéros de tête
+    // ("2016:4:74843"), d'autres firmwares XX:XX:XX:XX:XX:XX
+    unsigned int segments = 1;
     for (unsigned int i = 0; i < rawMac.length(); i++) {
-        if (rawMac[i] != ':') {
-            cleanMac += rawMac[i];
+        if (rawMac[i] == ':' || rawMac[i] == ',') segments++;
+    }
+    
+    // Supprimer les séparateurs, en complétant chaque segment à sa largeur
+    static const uint8_t napUapLapWidths[] = { 4, 2, 6 };
+    String cleanMac;
+    unsigned int segmentStart = 0;
+    unsigned int segment = 0;
+    for (unsigned int i = 0; i <= rawMac.length(); i++) {
+        if (i < rawMac.length() && rawMac[i] != ':' && rawMac[i] != ',') continue;
+        
+        unsigned int length = i - segmentStart;
+        unsigned int width = segments == 3 ? napUapLapWidths[segment] : (segments == 6 ? 2 : length);
+        if (length > width) return rawMac;
+        for (unsigned int pad = length; pad < width; pad++) {
+            cleanMac += '0';
         }
+        cleanMac += rawMac.substring(segmentStart, i);
+        segmentStart = i + 1;
+        segment++;
     }
     
     // Formater en XX:XX:XX:XX:XX:XX
@@ -449,47 +1144,920 @@ void SchreinBluetoothManager::processBluetoothCommands() {
         String response = readATResponse(100);
         
         if (response.length() > 0) {
-            if (response.startsWith("CONNECTED")) {
-                changeConnectionState(ConnectionState::CONNECTED);
+            if (response.startsWith("CONNECTED") || response.startsWith("+CONNECTED")) {
+                dispatchConnectionEvent(ConnectionEvent::LINK_UP);
                 resetAllRetryContexts();
-            } else if (response.startsWith("DISCONNECTED")) {
-                changeConnectionState(ConnectionState::DISCONNECTED);
+                
+                // "CONNECTED:<adresse>" : reprendre la session du pair
+                int separator = response.indexOf(':');
+                if (currentMode == Mode::SERVER && separator > 0) {
+                    activatePeer(parseMacAddress(response.substring(separator + 1)));
+                }
+            } else if (response.startsWith("DISCONNECTED") || response.startsWith("+DISCONNECTED")) {
+                dispatchConnectionEvent(ConnectionEvent::LINK_DOWN);
                 resetAllRetryContexts();
+                activePeer = -1;
             } else if (response.startsWith("ERROR")) {
-                changeConnectionState(ConnectionState::ERROR);
+                // Échec : ERROR n'accepte pas RETRY_DUE, le retry en attente est annulé
+                dispatchConnectionEvent(ConnectionEvent::FAILURE);
+                connectionRetryContext.reset();
                 if (onErrorCallback) onErrorCallback(response);
             }
             
-            // Transmettre les données reçues au callback
-            if (onDataReceivedCallback) {
-                onDataReceivedCallback(response);
+            // Transmettre les données reçues au canal ou au callback
+#if SBM_ENABLE_METRICS
+            unsigned long startMicros = micros();
+            dispatchReceivedData(response);
+            recordMetrics(metrics.receive, startMicros, response.length());
+#else
+            dispatchReceivedData(response);
+#endif
+        }
+    }
+}
+
+void SchreinBluetoothManager::dispatchReceivedData(const String &data) {
+    if (activePeer >= 0) {
+        peerSessions[activePeer].rxSequence++;
+        peerSessions[activePeer].bytesReceived += data.length();
+        peerSessions[activePeer].lastSeen = millis();
+    }
+    
+    // Session sécurisée : "!H:" poignée de main, "!S:" trame chiffrée
+    if (secureSession.enabled) {
+        if (data.startsWith("!H:")) {
+            handleSecureHello(data);
+            return;
+        }
+        if (data.startsWith("!S:")) {
+#if SBM_ENABLE_METRICS
+            unsigned long startMicros = micros();
+            handleSecureFrame(data);
+            recordMetrics(metrics.secureReceive, startMicros, data.length());
+#else
+            handleSecureFrame(data);
+#endif
+            return;
+        }
+        if (secureSession.requireSecure) {
+            secureSession.framesRejected++;
+            return;
+        }
+    }
+    
+    routeReceivedData(data);
+}
+
+void SchreinBluetoothManager::routeReceivedData(const String &data) {
+    // Trame de contrôle du transfert en masse : "$..."
+    if (data.length() > 0 && data[0] == '$' && handleBulkFrame(data)) {
+        return;
+    }
+    
+    // Trame de canal : "@<canal>:<données>"
+    if (data.length() > 2 && data[0] == '@') {
+        int separator = data.indexOf(':');
+        if (separator > 1 && separator <= 4) {
+            bool validChannel = true;
+            for (int i = 1; i < separator; i++) {
+                if (data[i] < '0' || data[i] > '9') {
+                    validChannel = false;
+                    break;
+                }
+            }
+            
+            if (validChannel) {
+                long channel = data.substring(1, separator).toInt();
+                if (channel < SBM_MAX_CHANNELS && channels[channel].onDataCallback) {
+                    channels[channel].onDataCallback(data.substring(separator + 1));
+                    return;
+                }
             }
         }
     }
+    
+    if (onDataReceivedCallback) {
+        onDataReceivedCallback(data);
+    }
 }
 
-void SchreinBluetoothManager::processIncomingData() {
-    // Lire les données utilisateur brutes
-    while (btStream.available()) {
-        char c = btStream.read();
+int8_t SchreinBluetoothManager::findPeer(const uint8_t *address) const {
+    for (uint8_t i = 0; i < SBM_MAX_PEERS; i++) {
+        if (peerSessions[i].inUse && memcmp(peerSessions[i].address, address, 6) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int8_t SchreinBluetoothManager::acquirePeer(const uint8_t *address) {
+    int8_t index = findPeer(address);
+    if (index >= 0) return index;
+    
+    // Emplacement libre, sinon la session inactive la plus ancienne, de
+    // préférence sans message en attente
+    int8_t oldest = -1;
+    for (uint8_t i = 0; i < SBM_MAX_PEERS; i++) {
+        if (!peerSessions[i].inUse) {
+            oldest = i;
+            break;
+        }
+        if (i == activePeer) continue;
+        
+        if (oldest < 0) {
+            oldest = i;
+            continue;
+        }
+        bool empty = peerSessions[i].count == 0;
+        bool oldestEmpty = peerSessions[oldest].count == 0;
+        if (empty != oldestEmpty ? empty : peerSessions[i].lastSeen < peerSessions[oldest].lastSeen) {
+            oldest = i;
+        }
+    }
+    
+    if (oldest < 0) return -1;
+    
+    PeerSession &peer = peerSessions[oldest];
+    if (peer.inUse && peer.count > 0) {
+        evictedPeerFrames += peer.count;
+        if (onErrorCallback) {
+            onErrorCallback("Peer session evicted, " + String(peer.count) +
+                            " queued messages dropped: " + macToString(peer.address));
+        }
+    }
+    peer.reset();
+    peer.inUse = true;
+    memcpy(peer.address, address, 6);
+    peer.lastSeen = millis();
+    return oldest;
+}
+
+void SchreinBluetoothManager::activatePeer(const String &address) {
+    uint8_t bytes[6];
+    if (!macToBytes(address, bytes)) {
+        activePeer = -1;
+        return;
+    }
+    
+    bool resumed = findPeer(bytes) >= 0;
+    activePeer = acquirePeer(bytes);
+    if (activePeer < 0) return;
+    
+    PeerSession &peer = peerSessions[activePeer];
+    peer.connections++;
+    peer.lastSeen = millis();
+    connectedDeviceAddress = macToString(bytes);
+    
+    if (onPeerConnectCallback) {
+        onPeerConnectCallback(connectedDeviceAddress, resumed);
+    }
+}
+
+void SchreinBluetoothManager::processPeerQueue() {
+    if (activePeer < 0 || !isConnected()) return;
+    
+    PeerSession &peer = peerSessions[activePeer];
+    for (uint8_t frame = 0; frame < SBM_CHANNEL_FRAMES_PER_LOOP && peer.count > 0; frame++) {
+        String data = peer.queue[peer.head];
+        peer.queue[peer.head] = "";
+        peer.head = (peer.head + 1) % SBM_PEER_QUEUE_SIZE;
+        peer.count--;
+        sendRawData(data);
+    }
+}
+
+bool SchreinBluetoothManager::macToBytes(const String &address, uint8_t *bytes) {
+    // Accepte "XX:XX:XX:XX:XX:XX", séparateurs optionnels
+    uint8_t digits = 0;
+    for (unsigned int i = 0; i < address.length() && digits < 12; i++) {
+        char c = address[i];
+        uint8_t value;
+        if (c >= '0' && c <= '9') value = c - '0';
+        else if (c >= 'A' && c <= 'F') value = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f') value = c - 'a' + 10;
+        else if (c == ':' || c == ',' || c == '-') continue;
+        else return false;
+        
+        if (digits % 2 == 0) bytes[digits / 2] = value << 4;
+        else bytes[digits / 2] |= value;
+        digits++;
+    }
+    return digits == 12;
+}
+
+String SchreinBluetoothManager::macToString(const uint8_t *bytes) {
+    static const char hexDigits[] = "0123456789ABCDEF";
+    String address;
+    address.reserve(17);
+    for (uint8_t i = 0; i < 6; i++) {
+        if (i > 0) address += ':';
+        address += hexDigits[bytes[i] >> 4];
+        address += hexDigits[bytes[i] & 0x0F];
+    }
+    return address;
+}
+
+void SchreinBluetoothManager::transmitRawLine(const uint8_t *data, size_t length) {
+    wakeModule();
+    
+    // Écriture directe depuis le tampon de l'appelant, sans String
+    btStream.write(data, length);
+    finishRawLine(length);
+}
+
+void SchreinBluetoothManager::finishRawLine(size_t length) {
+    btStream.println();
+    lastSendAttempt = millis();
+    
+    if (activePeer >= 0) {
+        peerSessions[activePeer].txSequence++;
+        peerSessions[activePeer].bytesSent += length + 2;
+    }
+}
+
+bool SchreinBluetoothManager::shouldStoreOffline() const {
+    // Tant que la file n'est pas vide, les nouveaux messages passent derrière :
+    // un message trop grand pour le journal est alors refusé, jamais émis hors ordre
+    return offlineQueue && (!isConnected() || !offlineQueue->isEmpty());
+}
+
+bool SchreinBluetoothManager::storeOffline(const uint8_t *data, size_t length) {
+    if (length > offlineQueue->getMaxRecordLength()) {
+        if (onErrorCallback) onErrorCallback("Message too large for offline log");
+        return false;
+    }
+    if (!offlineQueue->push(data, length)) {
+        if (onErrorCallback) onErrorCallback("Offline store rejected message");
+        return false;
+    }
+    return true;
+}
+
+void SchreinBluetoothManager::processOfflineQueue() {
+    if (!offlineQueue || !isConnected()) return;
+    
+    // Par lots, chaque message recopié du support vers le port par morceaux
+    // (pile bornée quelle que soit SBM_OFFLINE_MAX_RECORD) puis marqué consommé
+    uint8_t chunk[32];
+    for (uint8_t i = 0; i < SBM_OFFLINE_DRAIN_BATCH; i++) {
+        size_t length = offlineQueue->peekLength();
+        if (length == 0) return;
+        
+        wakeModule();
+        bool intact = true;
+        for (size_t offset = 0; offset < length && intact; offset += sizeof(chunk)) {
+            size_t size = min(sizeof(chunk), length - offset);
+            intact = offlineQueue->peekChunk(offset, chunk, size) == size;
+            if (intact) btStream.write(chunk, size);
+        }
+        finishRawLine(length);
+        offlineQueue->pop();
+        
+        if (!intact && onErrorCallback) onErrorCallback("Offline record unreadable, dropped");
+    }
+}
+
+void SchreinBluetoothManager::processChannelScheduler() {
+    if (!isConnected()) return;
+    
+    // En rafales : rien avant l'échéance, puis vider toutes les files d'un coup
+    uint16_t maxFrames = SBM_CHANNEL_FRAMES_PER_LOOP;
+    bool burstMode = lowPowerConfig.enabled && lowPowerConfig.burstInterval > 0;
+    if (burstMode) {
+        unsigned long now = millis();
+        if ((long)(now - nextBurstTime) < 0) return;
+        nextBurstTime = now + lowPowerConfig.burstInterval;
+        maxFrames = SBM_MAX_CHANNELS * SBM_CHANNEL_QUEUE_SIZE;
+    }
+    
+    // Round-robin pondéré lissé : chaque canal non vide gagne son poids,
+    // le plus crédité émet puis rend la somme des poids. Un canal de
+    // priorité P attend au plus (somme des poids / P) trames.
+    for (uint16_t frame = 0; frame < maxFrames; frame++) {
+        int16_t totalWeight = 0;
+        int8_t selected = -1;
+        
+        for (uint8_t i = 0; i < SBM_MAX_CHANNELS; i++) {
+            Channel &ch = channels[i];
+            if (!ch.isOpen || ch.count == 0) continue;
+            
+            ch.currentWeight += ch.priority;
+            totalWeight += ch.priority;
+            if (selected < 0 || ch.currentWeight > channels[selected].currentWeight) {
+                selected = i;
+            }
+        }
+        
+        if (selected < 0) return;
+        
+        if (frame == 0) powerStats.txBursts++;
+        powerStats.txFrames++;
         
-        // Transmettre les données brutes au callback
-        static String rawData = "";
-        rawData += c;
+        Channel &ch = channels[selected];
+        ch.currentWeight -= totalWeight;
         
-        if (c == '\n' || rawData.length() >= 256) {
-            if (onDataReceivedCallback) {
-                onDataReceivedCallback(rawData);
+        wakeModule();
+        btStream.print("@");
+        btStream.print(String(selected));
+        btStream.print(":");
+        btStream.print(ch.queue[ch.head]);
+        btStream.println();
+        lastSendAttempt = millis();
+        
+        ch.queue[ch.head] = "";
+        ch.head = (ch.head + 1) % SBM_CHANNEL_QUEUE_SIZE;
+        ch.count--;
+        if (ch.count == 0) ch.currentWeight = 0;
+    }
+}
+
+#if SBM_ENABLE_METRICS
+void SchreinBluetoothManager::recordMetrics(PathMetrics &path, unsigned long startMicros, size_t bytes) {
+    unsigned long elapsed = micros() - startMicros;
+    
+    path.calls++;
+    path.bytes += bytes;
+    path.totalMicros += elapsed;
+    if (elapsed > path.maxMicros) path.maxMicros = elapsed;
+    
+    uint8_t bucket = 0;
+    while ((elapsed >>= 1) != 0 && bucket < SBM_METRICS_BUCKETS - 1) {
+        bucket++;
+    }
+    path.histogram[bucket]++;
+}
+
+void SchreinBluetoothManager::printPathMetricsJson(Print &output, const char *name, const PathMetrics &path) const {
+    output.print("\"");
+    output.print(name);
+    output.print("\":{\"calls\":");
+    output.print(String(path.calls));
+    output.print(",\"bytes\":");
+    output.print(String(path.bytes));
+    output.print(",\"avg_us\":");
+    output.print(String(path.calls ? path.totalMicros / path.calls : 0UL));
+    output.print(",\"max_us\":");
+    output.print(String(path.maxMicros));
+    
+    // Percentiles : borne haute du seau de l'histogramme log2
+    const uint8_t percentiles[] = { 50, 90, 99 };
+    for (uint8_t p = 0; p < 3; p++) {
+        unsigned long threshold = (path.calls * percentiles[p] + 99) / 100;
+        unsigned long cumulated = 0;
+        unsigned long bound = 0;
+        for (uint8_t i = 0; i < SBM_METRICS_BUCKETS && threshold > 0; i++) {
+            cumulated += path.histogram[i];
+            if (cumulated >= threshold) {
+                bound = (2UL << i) - 1;
+                break;
             }
-            rawData = "";
         }
+        output.print(",\"p");
+        output.print(String(percentiles[p]));
+        output.print("_us\":");
+        output.print(String(min(bound, path.maxMicros)));
+    }
+    output.print("}");
+}
+#endif
+
+void SchreinBluetoothManager::processSecureSession() {
+    SecureSessionContext &session = secureSession;
+    if (!session.enabled || session.established || !isConnected()) return;
+    
+    // Réémettre notre aléa tant que le pair ne s'est pas authentifié
+    if (session.needsHello || millis() - session.lastHelloTime > SBM_SECURE_HANDSHAKE_TIMEOUT) {
+        sendSecureHello();
     }
 }
 
+void SchreinBluetoothManager::startSecureHandshake() {
+    secureSession.resetSession();
+    randomSource(secureSession.localNonce, sizeof(secureSession.localNonce));
+    secureSession.needsHello = true;
+}
+
+void SchreinBluetoothManager::sendSecureHello() {
+    wakeModule();
+    btStream.print("!H:");
+    printHex(secureSession.localNonce, sizeof(secureSession.localNonce));
+    btStream.println();
+    secureSession.needsHello = false;
+    secureSession.lastHelloTime = millis();
+}
+
+void SchreinBluetoothManager::handleSecureHello(const String &frame) {
+    SecureSessionContext &session = secureSession;
+    uint8_t nonce[8];
+    if (decodeHex(frame, 3, nonce, sizeof(nonce)) != sizeof(nonce)) return;
+    
+    // Même aléa déjà traité : rien à renégocier
+    if (session.keysReady && memcmp(nonce, session.peerNonce, sizeof(nonce)) == 0) return;
+    
+    // Nouvel aléa alors que des clés sont dérivées (pair redémarré, ou hello
+    // rejoué : il n'est pas authentifié). Ne jamais redériver avec notre aléa
+    // courant, un ancien aléa du pair redonnerait des clés déjà utilisées avec
+    // des séquences remises à zéro. Nouveau tirage, et le pair nous répond.
+    if (session.keysReady) {
+        startSecureHandshake();
+        sendSecureHello();
+        return;
+    }
+    
+    int order = memcmp(session.localNonce, nonce, sizeof(nonce));
+    if (order == 0) {
+        // Collision d'aléas : repartir avec un nouveau tirage
+        startSecureHandshake();
+        return;
+    }
+    
+    // Dérivation : bloc ChaCha20 sous la clé pré-partagée, entrée = aléa bas || aléa haut.
+    // Les 32 premiers octets chiffrent le sens bas -> haut, les 32 suivants l'inverse,
+    // si bien que les deux sens n'utilisent jamais la même clé.
+    uint8_t input[16];
+    uint8_t derived[64];
+    const uint8_t *low = order < 0 ? session.localNonce : nonce;
+    const uint8_t *high = order < 0 ? nonce : session.localNonce;
+    memcpy(input, low, 8);
+    memcpy(input + 8, high, 8);
+    SchreinChaChaPoly::block(presharedKey, input, derived);
+    
+    memcpy(session.peerNonce, nonce, sizeof(nonce));
+    memcpy(session.txKey, derived + (order < 0 ? 0 : 32), SchreinChaChaPoly::KEY_SIZE);
+    memcpy(session.rxKey, derived + (order < 0 ? 32 : 0), SchreinChaChaPoly::KEY_SIZE);
+    memset(derived, 0, sizeof(derived));
+    session.keysReady = true;
+    session.established = false;
+    session.txSequence = 0;
+    session.rxHighest = 0;
+    session.rxWindow = 0;
+    
+    // Renvoyer notre aléa (le pair a pu le manquer) puis confirmer la clé
+    sendSecureHello();
+    transmitSecureFrame(secureBuffer + 4, 0);
+}
+
+void SchreinBluetoothManager::handleSecureFrame(const String &frame) {
+    SecureSessionContext &session = secureSession;
+    if (!session.keysReady) {
+        session.framesRejected++;
+        return;
+    }
+    
+    // Déchiffrement en place dans le tampon de trame
+    size_t length = decodeHex(frame, 3, secureBuffer, SBM_SECURE_MAX_PAYLOAD + SBM_SECURE_OVERHEAD);
+    if (length < SBM_SECURE_OVERHEAD) {
+        session.framesRejected++;
+        return;
+    }
+    
+    size_t payloadLength = length - SBM_SECURE_OVERHEAD;
+    uint32_t sequence = (uint32_t)secureBuffer[0] | ((uint32_t)secureBuffer[1] << 8) |
+                        ((uint32_t)secureBuffer[2] << 16) | ((uint32_t)secureBuffer[3] << 24);
+    
+    // Fenêtre anti-rejeu de 32 trames
+    uint32_t age = session.rxHighest - sequence;
+    if (sequence == 0 ||
+        (sequence <= session.rxHighest && (age >= 32 || (session.rxWindow & (1UL << age))))) {
+        session.framesRejected++;
+        return;
+    }
+    
+    uint8_t nonce[SchreinChaChaPoly::NONCE_SIZE] = {};
+    memcpy(nonce, secureBuffer, 4);
+    if (!SchreinChaChaPoly::decrypt(session.rxKey, nonce, secureBuffer, 4,
+                                    secureBuffer + 4, payloadLength, secureBuffer + 4 + payloadLength)) {
+        session.framesRejected++;
+        return;
+    }
+    
+    if (sequence > session.rxHighest) {
+        uint32_t shift = sequence - session.rxHighest;
+        session.rxWindow = shift >= 32 ? 0 : session.rxWindow << shift;
+        session.rxHighest = sequence;
+        age = 0;
+    }
+    session.rxWindow |= 1UL << age;
+    session.established = true;
+    
+    // Trame vide : confirmation de clé uniquement
+    if (payloadLength > 0) {
+        secureBuffer[4 + payloadLength] = '\0';
+        routeReceivedData(String((const char *)(secureBuffer + 4)));
+    }
+}
+
+bool SchreinBluetoothManager::transmitSecureFrame(uint8_t *data, size_t length) {
+    SecureSessionContext &session = secureSession;
+    
+#if SBM_ENABLE_METRICS
+    unsigned long startMicros = micros();
+#endif
+    
+    wakeModule();
+    uint32_t sequence = ++session.txSequence;
+    uint8_t header[4] = {
+        (uint8_t)sequence, (uint8_t)(sequence >> 8),
+        (uint8_t)(sequence >> 16), (uint8_t)(sequence >> 24)
+    };
+    uint8_t nonce[SchreinChaChaPoly::NONCE_SIZE] = {};
+    memcpy(nonce, header, 4);
+    
+    uint8_t tag[SchreinChaChaPoly::TAG_SIZE];
+    SchreinChaChaPoly::encrypt(session.txKey, nonce, header, 4, data, length, tag);
+    
+    btStream.print("!S:");
+    printHex(header, 4);
+    printHex(data, length);
+    printHex(tag, sizeof(tag));
+    btStream.println();
+    lastSendAttempt = millis();
+    
+#if SBM_ENABLE_METRICS
+    recordMetrics(metrics.secureSend, startMicros, length);
+#endif
+    return true;
+}
+
+void SchreinBluetoothManager::updatePowerState(bool wakeOnly) {
+    if (!lowPowerConfig.enabled) return;
+    
+    bool canSleep = canModuleSleep();
+    unsigned long idle = getIdleDuration();
+    if (!moduleAwake && (idle == 0 || !canSleep)) {
+        setModulePower(true);
+    } else if (moduleAwake && !wakeOnly && canSleep && idle >= lowPowerConfig.minSleepDuration) {
+        setModulePower(false);
+    }
+}
+
+bool SchreinBluetoothManager::canModuleSleep() const {
+    // Module éteint = liaison coupée : jamais une fois connecté, ni en
+    // connexion, ni en mode serveur où il doit rester joignable
+    if (currentMode != Mode::CLIENT) return false;
+    return connectionState == ConnectionState::DISCONNECTED ||
+           connectionState == ConnectionState::ERROR ||
+           connectionState == ConnectionState::RETRY_PENDING;
+}
+
+void SchreinBluetoothManager::wakeModule() {
+    if (moduleAwake) return;
+    
+    // Les octets écrits pendant le démarrage du module seraient perdus
+    setModulePower(true);
+    delay(lowPowerConfig.wakeupDelay);
+}
+
+void SchreinBluetoothManager::setModulePower(bool awake) {
+    if (moduleAwake == awake) return;
+    
+    unsigned long now = millis();
+    if (moduleAwake) {
+        powerStats.awakeTime += now - lastPowerTransition;
+    } else {
+        powerStats.sleepTime += now - lastPowerTransition;
+        powerStats.wakeups++;
+    }
+    lastPowerTransition = now;
+    moduleAwake = awake;
+    
+    // Broche KEY/EN pilotée par l'application
+    if (onModulePowerCallback) {
+        onModulePowerCallback(awake);
+    }
+}
+
+unsigned long SchreinBluetoothManager::remainingUntil(unsigned long deadline, unsigned long now) {
+    long remaining = (long)(deadline - now);
+    return remaining > 0 ? (unsigned long)remaining : 0;
+}
+
+void SchreinBluetoothManager::resetAllChannels() {
+    for (uint8_t i = 0; i < SBM_MAX_CHANNELS; i++) {
+        channels[i].reset();
+    }
+}
+
+void SchreinBluetoothManager::processBulkTransfer() {
+    BulkTransferContext &tx = bulkTransferContext;
+    if (!tx.isActive) return;
+    
+    // Empreinte du contenu avant toute négociation, même hors connexion
+    if (tx.crcOffset < tx.totalSize) {
+        hashBulkContent();
+        return;
+    }
+    
+    if (!isConnected()) return;
+    
+    wakeModule();
+    unsigned long now = millis();
+    
+    // Négociation de l'offset de reprise
+    if (tx.needsHandshake) {
+        btStream.print("$BEGIN:");
+        btStream.print(String(tx.totalSize));
+        btStream.print(":");
+        printCrc32(tx.crc ^ 0xFFFFFFFFUL);
+        btStream.println();
+        tx.needsHandshake = false;
+        tx.awaitingHandshake = true;
+        tx.lastActivityTime = now;
+        return;
+    }
+    
+    if (tx.awaitingHandshake) {
+        if (now - tx.lastActivityTime > SBM_BULK_ACK_TIMEOUT) {
+            tx.needsHandshake = true;
+        }
+        return;
+    }
+    
+    // Tout est acquitté : envoyer (ou renvoyer) le CRC final
+    if (tx.ackedOffset >= tx.totalSize) {
+        if (!tx.endSent || now - tx.lastActivityTime > SBM_BULK_ACK_TIMEOUT) {
+            btStream.print("$END:");
+            btStream.print(String(tx.totalSize));
+            btStream.print(":");
+            printCrc32(tx.crc ^ 0xFFFFFFFFUL);
+            btStream.println();
+            tx.endSent = true;
+            tx.lastActivityTime = now;
+        }
+        return;
+    }
+    
+    // ACK en retard : réémettre depuis le dernier offset confirmé (go-back-N)
+    if (tx.nextOffset > tx.ackedOffset && now - tx.lastActivityTime > SBM_BULK_ACK_TIMEOUT) {
+        tx.nextOffset = tx.ackedOffset;
+        tx.lastActivityTime = now;
+    }
+    
+    if (tx.nextOffset >= tx.totalSize ||
+        tx.nextOffset - tx.ackedOffset >= (uint32_t)SBM_BULK_WINDOW * SBM_BULK_CHUNK_SIZE) {
+        return;
+    }
+    
+    uint32_t remaining = tx.totalSize - tx.nextOffset;
+    size_t length = remaining < SBM_BULK_CHUNK_SIZE ? (size_t)remaining : SBM_BULK_CHUNK_SIZE;
+    size_t readLength = tx.reader(tx.nextOffset, bulkBuffer, length);
+    if (readLength == 0 || readLength > length) {
+        if (onErrorCallback) onErrorCallback("Bulk reader failed");
+        finishBulkTransfer(false);
+        return;
+    }
+    
+    uint32_t chunkEnd = tx.nextOffset + readLength;
+    
+    btStream.print("$BLK:");
+    btStream.print(String(tx.nextOffset));
+    btStream.print(":");
+    printHex(bulkBuffer, readLength);
+    btStream.println();
+    lastSendAttempt = now;
+    
+    if (tx.nextOffset == tx.ackedOffset) {
+        tx.lastActivityTime = now;
+    }
+    tx.nextOffset = chunkEnd;
+}
+
+void SchreinBluetoothManager::hashBulkContent() {
+    BulkTransferContext &tx = bulkTransferContext;
+    
+    // Une fenêtre de blocs par appel : loop() reste non bloquant
+    for (uint8_t i = 0; i < SBM_BULK_WINDOW && tx.crcOffset < tx.totalSize; i++) {
+        uint32_t remaining = tx.totalSize - tx.crcOffset;
+        size_t length = remaining < SBM_BULK_CHUNK_SIZE ? (size_t)remaining : SBM_BULK_CHUNK_SIZE;
+        size_t readLength = tx.reader(tx.crcOffset, bulkBuffer, length);
+        if (readLength == 0 || readLength > length) {
+            if (onErrorCallback) onErrorCallback("Bulk reader failed");
+            finishBulkTransfer(false);
+            return;
+        }
+        
+        tx.crc = updateCrc32(tx.crc, bulkBuffer, readLength);
+        tx.crcOffset += readLength;
+    }
+}
+
+bool SchreinBluetoothManager::handleBulkFrame(const String &frame) {
+    if (frame.startsWith("$ACK:")) {
+        handleBulkAck(strtoul(frame.c_str() + 5, nullptr, 10));
+        return true;
+    }
+    
+    if (frame.startsWith("$CRC:")) {
+        if (bulkTransferContext.isActive && bulkTransferContext.endSent) {
+            finishBulkTransfer(frame.startsWith("$CRC:OK"));
+        }
+        return true;
+    }
+    
+    // Les trames suivantes concernent le récepteur
+    if (!onBulkDataReceivedCallback) {
+        return frame.startsWith("$BEGIN:") || frame.startsWith("$BLK:") || frame.startsWith("$END:");
+    }
+    
+    BulkReceiveContext &rx = bulkReceiveContext;
+    
+    if (frame.startsWith("$BEGIN:")) {
+        uint32_t totalSize = strtoul(frame.c_str() + 7, nullptr, 10);
+        int separator = frame.indexOf(':', 7);
+        bool hasId = separator > 7;
+        uint32_t transferId = hasId ? strtoul(frame.c_str() + separator + 1, nullptr, 16) : 0;
+        
+        // Même contenu interrompu : reprendre à l'offset déjà écrit, sinon repartir de 0
+        if (!rx.isActive || !hasId || rx.totalSize != totalSize || rx.transferId != transferId) {
+            rx.reset();
+            rx.isActive = true;
+            rx.totalSize = totalSize;
+            rx.transferId = transferId;
+        }
+        sendBulkAck();
+        return true;
+    }
+    
+    if (frame.startsWith("$BLK:")) {
+        int separator = frame.indexOf(':', 5);
+        if (separator > 5) {
+            handleBulkBlock(frame, separator);
+        }
+        return true;
+    }
+    
+    if (frame.startsWith("$END:")) {
+        handleBulkEnd(frame);
+        return true;
+    }
+    
+    return false;
+}
+
+void SchreinBluetoothManager::handleBulkAck(uint32_t offset) {
+    BulkTransferContext &tx = bulkTransferContext;
+    if (!tx.isActive) return;
+    
+    if (tx.awaitingHandshake) {
+        // Même contenu (même CRC) : toute reprise dans les bornes est valide
+        if (offset > tx.totalSize) {
+            if (onErrorCallback) onErrorCallback("Bulk resume offset mismatch");
+            finishBulkTransfer(false);
+            return;
+        }
+        tx.awaitingHandshake = false;
+        tx.endSent = false;
+        tx.ackedOffset = offset;
+        tx.nextOffset = offset;
+        tx.lastActivityTime = millis();
+        return;
+    }
+    
+    if (offset > tx.ackedOffset && offset <= tx.nextOffset) {
+        tx.ackedOffset = offset;
+        tx.lastActivityTime = millis();
+    }
+}
+
+void SchreinBluetoothManager::handleBulkBlock(const String &frame, int separator) {
+    BulkReceiveContext &rx = bulkReceiveContext;
+    uint32_t offset = strtoul(frame.c_str() + 5, nullptr, 10);
+    
+    // Bloc hors séquence : rappeler au pair l'offset attendu
+    if (!rx.isActive || offset != rx.expectedOffset) {
+        if (rx.isActive) sendBulkAck();
+        return;
+    }
+    
+    // Décoder l'hexadécimal directement dans le tampon de bloc
+    size_t length = decodeHex(frame, separator + 1, bulkBuffer, SBM_BULK_CHUNK_SIZE);
+    if (length == 0 || rx.expectedOffset + length > rx.totalSize) return;
+    
+    if (!onBulkDataReceivedCallback(offset, bulkBuffer, length)) {
+        if (onErrorCallback) onErrorCallback("Bulk writer failed");
+        return;
+    }
+    
+    rx.crc = updateCrc32(rx.crc, bulkBuffer, length);
+    rx.expectedOffset += length;
+    rx.chunksSinceAck++;
+    
+    if (rx.chunksSinceAck >= SBM_BULK_ACK_EVERY || rx.expectedOffset >= rx.totalSize) {
+        sendBulkAck();
+    }
+}
+
+void SchreinBluetoothManager::handleBulkEnd(const String &frame) {
+    BulkReceiveContext &rx = bulkReceiveContext;
+    int separator = frame.indexOf(':', 5);
+    if (separator <= 5) return;
+    
+    uint32_t totalSize = strtoul(frame.c_str() + 5, nullptr, 10);
+    uint32_t crc = strtoul(frame.c_str() + separator + 1, nullptr, 16);
+    
+    bool success;
+    bool notify = true;
+    if (rx.isActive) {
+        success = rx.expectedOffset == totalSize && (rx.crc ^ 0xFFFFFFFFUL) == crc;
+    } else {
+        // END réémis après la perte de notre "$CRC:OK"
+        success = rx.completedSize == totalSize && rx.completedCrc == crc && totalSize > 0;
+        notify = false;
+    }
+    
+    wakeModule();
+    btStream.println(success ? "$CRC:OK" : "$CRC:FAIL");
+    
+    if (rx.isActive) {
+        rx.reset();
+        if (success) {
+            rx.completedSize = totalSize;
+            rx.completedCrc = crc;
+        }
+    }
+    
+    if (notify && onBulkReceiveCompleteCallback) {
+        onBulkReceiveCompleteCallback(success, totalSize);
+    }
+}
+
+size_t SchreinBluetoothManager::decodeHex(const String &text, unsigned int start, uint8_t *output, size_t maxLength) {
+    // S'arrête en fin de ligne ; 0 si un caractère n'est pas hexadécimal
+    size_t length = 0;
+    unsigned int i = start;
+    while (i + 1 < text.length() && length < maxLength) {
+        if (text[i] == '\r' || text[i] == '\n') break;
+        
+        uint8_t value = 0;
+        for (uint8_t n = 0; n < 2; n++) {
+            char c = text[i + n];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else return 0;
+        }
+        output[length++] = value;
+        i += 2;
+    }
+    return length;
+}
+
+void SchreinBluetoothManager::finishBulkTransfer(bool success) {
+    uint32_t totalSize = bulkTransferContext.totalSize;
+    bulkTransferContext.reset();
+    
+    if (onBulkTransferCompleteCallback) {
+        onBulkTransferCompleteCallback(success, totalSize);
+    }
+}
+
+void SchreinBluetoothManager::sendBulkAck() {
+    wakeModule();
+    btStream.print("$ACK:");
+    btStream.print(String(bulkReceiveContext.expectedOffset));
+    btStream.println();
+    bulkReceiveContext.chunksSinceAck = 0;
+}
+
+void SchreinBluetoothManager::printHex(const uint8_t *data, size_t length) {
+    static const char hexDigits[] = "0123456789ABCDEF";
+    for (size_t i = 0; i < length; i++) {
+        btStream.write((uint8_t)hexDigits[data[i] >> 4]);
+        btStream.write((uint8_t)hexDigits[data[i] & 0x0F]);
+    }
+}
+
+void SchreinBluetoothManager::printCrc32(uint32_t crc) {
+    uint8_t crcBytes[4] = {
+        (uint8_t)(crc >> 24), (uint8_t)(crc >> 16),
+        (uint8_t)(crc >> 8), (uint8_t)crc
+    };
+    printHex(crcBytes, 4);
+}
+
+uint32_t SchreinBluetoothManager::updateCrc32(uint32_t crc, const uint8_t *data, size_t length) {
+    // CRC-32 IEEE 802.3 bit à bit : pas de table en RAM
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+        }
+    }
+    return crc;
+}
+
 void SchreinBluetoothManager::processConnectionRetry() {
     if (!connectionRetryContext.isRetrying) return;
     
     if (millis() >= connectionRetryContext.nextRetryTime) {
+        // Tentative de connexion : RETRY_PENDING -> CONNECTING. Refusée par la
+        // table (l'état a changé entre-temps) : le retry n'a plus lieu d'être
+        if (!dispatchConnectionEvent(ConnectionEvent::RETRY_DUE)) {
+            connectionRetryContext.reset();
+            return;
+        }
+        
         connectionRetryContext.currentAttempt++;
         
         if (onRetryAttemptCallback) {
@@ -497,7 +2065,8 @@ void SchreinBluetoothManager::processConnectionRetry() {
                                  connectionRetryContext.maxAttempts);
         }
         
-        // Tentative de connexion
+        lastConnectionAttempt = millis();
+        
         String formattedAddress = connectionRetryContext.targetAddress;
         formattedAddress.replace(":", ",");
         String command = "AT+CONN=" + formattedAddress;
@@ -509,19 +2078,25 @@ void SchreinBluetoothManager::processConnectionRetry() {
                 onRetrySuccessCallback(connectionRetryContext.currentAttempt);
             }
             connectionRetryContext.reset();
+            dispatchConnectionEvent(ConnectionEvent::LINK_UP);
         } else if (connectionRetryContext.currentAttempt >= connectionRetryContext.maxAttempts) {
             if (onRetryFailedCallback) {
                 onRetryFailedCallback("Max connection retries exceeded");
             }
-            changeConnectionState(ConnectionState::ERROR);
             connectionRetryContext.reset();
+            dispatchConnectionEvent(ConnectionEvent::FAILURE);
         } else {
-            // Programmer le prochain retry
+            // Programmer le prochain retry : CONNECTING -> RETRY_PENDING
             connectionRetryContext.currentDelay = calculateRetryDelay(
                 connectionRetryContext.currentAttempt, 
                 retryConfig.connectionRetryDelay
             );
             connectionRetryContext.nextRetryTime = millis() + connectionRetryContext.currentDelay;
+            
+            // Retry désactivé entre-temps : rester en CONNECTING jusqu'au timeout
+            if (!dispatchConnectionEvent(ConnectionEvent::RETRY_SCHEDULED)) {
+                connectionRetryContext.reset();
+            }
         }
     }
 }
@@ -538,10 +2113,15 @@ void SchreinBluetoothManager::processSendRetry() {
         }
         
         // Tentative d'envoi
+        wakeModule();
         btStream.print(sendRetryContext.lastCommand);
         btStream.println();
         lastSendAttempt = millis();
         
+#if SBM_ENABLE_METRICS
+        recordMetrics(metrics.sendWithRetry, sendRetryQueuedMicros, sendRetryContext.lastCommand.length());
+#endif
+        
         // Pour l'envoi, nous considérons que c'est toujours un succès
         if (onRetrySuccessCallback) {
             onRetrySuccessCallback(sendRetryContext.currentAttempt);
@@ -597,7 +2177,10 @@ bool SchreinBluetoothManager::startConnectionRetry(const String &address) {
     connectionRetryContext.currentDelay = retryConfig.connectionRetryDelay;
     connectionRetryContext.nextRetryTime = millis() + connectionRetryContext.currentDelay;
     
-    changeConnectionState(ConnectionState::RETRY_PENDING);
+    if (!dispatchConnectionEvent(ConnectionEvent::RETRY_SCHEDULED)) {
+        connectionRetryContext.reset();
+        return false;
+    }
     return true;
 }
 
@@ -653,6 +2236,10 @@ void SchreinBluetoothManager::resetAllRetryContexts() {
 }
 
 bool SchreinBluetoothManager::sendATCommand(String command, String expectedResponse, unsigned long timeout) {
+#if SBM_ENABLE_METRICS
+    unsigned long startMicros = micros();
+#endif
+    wakeModule();
     btStream.println(command);
     
     unsigned long startTime = millis();
@@ -660,15 +2247,20 @@ bool SchreinBluetoothManager::sendATCommand(String command, String expectedRespo
     
     while (millis() - startTime < timeout) {
         if (btStream.available()) {
-            char c = btStream.read();
-            response += c;
+            appendToMatchWindow(response, btStream.read(), expectedResponse.length());
             
-            if (response.indexOf(expectedResponse) >= 0) {
+            if (response.endsWith(expectedResponse)) {
+#if SBM_ENABLE_METRICS
+                recordMetrics(metrics.atCommand, startMicros, command.length());
+#endif
                 return true;
             }
         }
     }
     
+#if SBM_ENABLE_METRICS
+    recordMetrics(metrics.atCommand, startMicros, command.length());
+#endif
     if (onErrorCallback) onErrorCallback("AT command timeout: " + command);
     return false;
 }
@@ -2,12 +2,128 @@
 #define SCHREINBLUETOOTHMANAGER_H
 
 #include <Arduino.h>
+#include "SchreinLinkCapture.h"
+#include "SchreinChaChaPoly.h"
+#include "SchreinOfflineQueue.h"
 
 // Définition de ULONG_MAX si non définie
 #ifndef ULONG_MAX
 #define ULONG_MAX 0xFFFFFFFFUL
 #endif
 
+// Configuration à la compilation. Les bibliothèques Arduino sont compilées
+// sans les #define du sketch : ces macros se surchargent uniquement par
+// option de compilation (-D, build_flags, platform.txt), jamais avant
+// l'include. Celles qui fixent la taille de la classe entrent dans
+// SBM_LAYOUT ci-dessous : une surcharge vue d'un seul côté fait échouer
+// l'édition de liens au lieu de corrompre la mémoire.
+
+// Longueur maximale d'une ligne reçue (réponse AT ou données)
+#ifndef SBM_MAX_LINE_LENGTH
+#define SBM_MAX_LINE_LENGTH 256
+#endif
+
+// Trace des transitions de la machine à états
+#ifndef SBM_TRACE_SIZE
+#define SBM_TRACE_SIZE 16               // Entrées conservées (les plus récentes)
+#endif
+
+// Mesures de performance par chemin (micros() à chaque message si activé)
+#ifndef SBM_ENABLE_METRICS
+#define SBM_ENABLE_METRICS 0
+#endif
+
+#define SBM_METRICS_BUCKETS 16          // Histogramme log2 des durées en µs
+
+// Multiplexage de canaux logiques (option -D uniquement)
+#ifndef SBM_MAX_CHANNELS
+#define SBM_MAX_CHANNELS 4              // Nombre de canaux logiques
+#endif
+
+#ifndef SBM_CHANNEL_QUEUE_SIZE
+#define SBM_CHANNEL_QUEUE_SIZE 4        // Trames en attente par canal
+#endif
+
+#ifndef SBM_CHANNEL_FRAMES_PER_LOOP
+#define SBM_CHANNEL_FRAMES_PER_LOOP 2   // Trames émises par appel à loop()
+#endif
+
+// Stockage hors connexion (option -D uniquement)
+#ifndef SBM_OFFLINE_DRAIN_BATCH
+#define SBM_OFFLINE_DRAIN_BATCH 8       // Messages relus par appel à loop()
+#endif
+
+// Session sécurisée (option -D uniquement)
+#ifndef SBM_SECURE_MAX_PAYLOAD
+#define SBM_SECURE_MAX_PAYLOAD 96       // Octets de données par trame chiffrée
+#endif
+
+#ifndef SBM_SECURE_HANDSHAKE_TIMEOUT
+#define SBM_SECURE_HANDSHAKE_TIMEOUT 3000
+#endif
+
+#define SBM_SECURE_OVERHEAD 20          // Séquence (4) + tag Poly1305 (16)
+
+// Une ligne "!S:<hexa>" doit tenir dans une ligne RX
+#if (SBM_SECURE_MAX_PAYLOAD + SBM_SECURE_OVERHEAD) * 2 + 5 > SBM_MAX_LINE_LENGTH
+#error "SBM_SECURE_MAX_PAYLOAD too large for SBM_MAX_LINE_LENGTH"
+#endif
+
+// Sessions multi-pairs en mode serveur (option -D uniquement)
+#ifndef SBM_MAX_PEERS
+#define SBM_MAX_PEERS 8                 // Sessions conservées entre reconnexions
+#endif
+
+#ifndef SBM_PEER_QUEUE_SIZE
+#define SBM_PEER_QUEUE_SIZE 2           // Messages en attente par pair absent
+#endif
+
+// Transfert en masse (option -D uniquement)
+#ifndef SBM_BULK_CHUNK_SIZE
+#define SBM_BULK_CHUNK_SIZE 64          // Octets par bloc (encodés en hexa)
+#endif
+
+#ifndef SBM_BULK_WINDOW
+#define SBM_BULK_WINDOW 4               // Blocs non acquittés au maximum
+#endif
+
+#ifndef SBM_BULK_ACK_EVERY
+#define SBM_BULK_ACK_EVERY 2            // Le récepteur acquitte tous les N blocs
+#endif
+
+#ifndef SBM_BULK_ACK_TIMEOUT
+#define SBM_BULK_ACK_TIMEOUT 2000       // Réémission de la fenêtre après 2 s
+#endif
+
+// Une ligne "$BLK:<offset>:<hexa>" doit tenir dans une ligne RX
+#if SBM_BULK_CHUNK_SIZE * 2 + 24 > SBM_MAX_LINE_LENGTH
+#error "SBM_BULK_CHUNK_SIZE too large for SBM_MAX_LINE_LENGTH"
+#endif
+
+#if SBM_BULK_ACK_EVERY > SBM_BULK_WINDOW
+#error "SBM_BULK_ACK_EVERY must not exceed SBM_BULK_WINDOW"
+#endif
+
+// Index et compteurs des tables fixes sur 8 bits
+#if SBM_MAX_CHANNELS > 127 || SBM_MAX_PEERS > 127
+#error "SBM_MAX_CHANNELS and SBM_MAX_PEERS must not exceed 127"
+#endif
+
+#if SBM_CHANNEL_QUEUE_SIZE > 255 || SBM_PEER_QUEUE_SIZE > 255 || SBM_TRACE_SIZE > 255
+#error "SBM_CHANNEL_QUEUE_SIZE, SBM_PEER_QUEUE_SIZE and SBM_TRACE_SIZE must not exceed 255"
+#endif
+
+// Empreinte de la configuration qui fixe la taille de la classe. Elle fait
+// partie de la signature du constructeur compilé dans la bibliothèque : un
+// sketch compilé avec d'autres valeurs référence un constructeur inexistant
+// ("undefined reference to ...SchreinBluetoothLayout<...>").
+template <unsigned long... Values>
+struct SchreinBluetoothLayout {};
+
+#define SBM_LAYOUT SchreinBluetoothLayout<SBM_TRACE_SIZE, SBM_MAX_CHANNELS, \
+    SBM_CHANNEL_QUEUE_SIZE, SBM_SECURE_MAX_PAYLOAD, SBM_MAX_PEERS, \
+    SBM_PEER_QUEUE_SIZE, SBM_BULK_CHUNK_SIZE, SBM_CAPTURE_SIZE, SBM_ENABLE_METRICS>
+
 class SchreinBluetoothManager {
 public:
     // Modes de fonctionnement
@@ -25,6 +141,26 @@ public:
         RETRY_PENDING     // En attente de retry
     };
 
+    // Événements pilotant la machine à états de connexion
+    enum class ConnectionEvent : uint8_t {
+        CONNECT_REQUESTED,     // Connexion directe demandée
+        RETRY_SCHEDULED,       // Tentative de connexion programmée
+        RETRY_DUE,             // Délai de retry écoulé, tentative lancée
+        LINK_UP,               // Le module signale CONNECTED
+        LINK_DOWN,             // Le module signale DISCONNECTED
+        FAILURE,               // Erreur, timeout ou retries épuisés
+        DISCONNECT_REQUESTED   // Déconnexion ou réinitialisation locale
+    };
+
+    // Entrée de la trace des transitions
+    struct TransitionTraceEntry {
+        uint32_t timestamp;    // millis() au moment de l'événement
+        uint8_t event;         // ConnectionEvent
+        uint8_t fromState;     // ConnectionState de départ
+        uint8_t toState;       // ConnectionState d'arrivée
+        bool accepted;         // false si l'événement a été rejeté
+    };
+
     // Structure pour la gestion des retry
     struct RetryConfig {
         bool enableConnectionRetry = true;
@@ -45,6 +181,43 @@ public:
         unsigned long maxBackoffDelay = 30000;      // 30 secondes max
     };
 
+    // Configuration du mode basse consommation
+    struct LowPowerConfig {
+        bool enabled = false;
+        unsigned long burstInterval = 0;       // Émission des canaux par rafales (0 = immédiate)
+        unsigned long minSleepDuration = 100;  // Inactivité minimale avant mise en veille
+        unsigned long wakeupDelay = 1000;      // Démarrage du module après réveil, avant écriture
+    };
+
+    // Indicateurs de consommation (en ms et en compteurs)
+    struct PowerStats {
+        unsigned long awakeTime = 0;
+        unsigned long sleepTime = 0;
+        unsigned long wakeups = 0;
+        unsigned long txBursts = 0;
+        unsigned long txFrames = 0;
+    };
+
+    // Mesures d'un chemin d'émission ou de réception
+    struct PathMetrics {
+        unsigned long calls = 0;
+        unsigned long bytes = 0;
+        unsigned long totalMicros = 0;
+        unsigned long maxMicros = 0;
+        unsigned long histogram[SBM_METRICS_BUCKETS] = {};  // [i] : durées < 2^(i+1) µs
+    };
+
+    // Mesures de l'ensemble des chemins (SBM_ENABLE_METRICS)
+    struct LinkMetrics {
+        PathMetrics sendRawData;      // String, émission immédiate
+        PathMetrics sendRawBytes;     // Tampon de l'appelant, sans String
+        PathMetrics sendWithRetry;    // De la mise en file à l'émission effective
+        PathMetrics receive;          // Découpage et distribution d'une ligne reçue
+        PathMetrics atCommand;        // Commande AT jusqu'à la réponse (latence module)
+        PathMetrics secureSend;       // Chiffrement et émission d'une trame
+        PathMetrics secureReceive;    // Vérification et déchiffrement d'une trame
+    };
+
     // Structure pour stocker les informations de retry
     struct RetryContext {
         bool isRetrying = false;
@@ -70,7 +243,162 @@ public:
         }
     };
 
-    SchreinBluetoothManager(Stream &btStream, Mode mode = Mode::SERVER);
+    // Canal logique multiplexé sur le lien série
+    // Trame sur le fil : "@<canal>:<données>\r\n"
+    struct Channel {
+        bool isOpen = false;
+        uint8_t priority = 1;        // Poids dans l'ordonnanceur (1 = plus faible)
+        int16_t currentWeight = 0;   // Crédit du round-robin pondéré
+        String queue[SBM_CHANNEL_QUEUE_SIZE];
+        uint8_t head = 0;
+        uint8_t count = 0;
+        unsigned long framesDropped = 0;
+        void (*onDataCallback)(String data) = nullptr;
+        
+        void reset() {
+            isOpen = false;
+            priority = 1;
+            currentWeight = 0;
+            for (uint8_t i = 0; i < SBM_CHANNEL_QUEUE_SIZE; i++) {
+                queue[i] = "";
+            }
+            head = 0;
+            count = 0;
+            framesDropped = 0;
+            onDataCallback = nullptr;
+        }
+    };
+
+    // Session d'un pair client (mode serveur), conservée entre reconnexions
+    struct PeerSession {
+        bool inUse = false;
+        uint8_t address[6] = {0, 0, 0, 0, 0, 0};
+        unsigned long lastSeen = 0;
+        uint16_t connections = 0;
+        uint16_t txSequence = 0;       // Messages émis vers ce pair
+        uint16_t rxSequence = 0;       // Lignes reçues de ce pair
+        unsigned long bytesSent = 0;
+        unsigned long bytesReceived = 0;
+        unsigned long framesDropped = 0;
+        String queue[SBM_PEER_QUEUE_SIZE];
+        uint8_t head = 0;
+        uint8_t count = 0;
+        
+        void reset() {
+            inUse = false;
+            for (uint8_t i = 0; i < 6; i++) {
+                address[i] = 0;
+            }
+            lastSeen = 0;
+            connections = 0;
+            txSequence = 0;
+            rxSequence = 0;
+            bytesSent = 0;
+            bytesReceived = 0;
+            framesDropped = 0;
+            for (uint8_t i = 0; i < SBM_PEER_QUEUE_SIZE; i++) {
+                queue[i] = "";
+            }
+            head = 0;
+            count = 0;
+        }
+    };
+
+    // Session sécurisée : poignée de main "!H:<aléa>" dans chaque sens, clés
+    // dérivées de la clé pré-partagée, puis trames "!S:<séquence|chiffré|tag>"
+    struct SecureSessionContext {
+        bool enabled = false;
+        bool requireSecure = false;    // Rejeter les lignes reçues en clair
+        bool keysReady = false;        // Aléa du pair reçu, clés dérivées
+        bool established = false;      // Trame authentique reçue du pair
+        bool needsHello = false;
+        uint8_t localNonce[8] = {};
+        uint8_t peerNonce[8] = {};
+        uint8_t txKey[SchreinChaChaPoly::KEY_SIZE] = {};
+        uint8_t rxKey[SchreinChaChaPoly::KEY_SIZE] = {};
+        uint32_t txSequence = 0;
+        uint32_t rxHighest = 0;        // Plus haute séquence acceptée
+        uint32_t rxWindow = 0;         // Bit i : séquence rxHighest - i déjà vue
+        unsigned long lastHelloTime = 0;
+        unsigned long framesRejected = 0;
+        
+        void resetSession() {
+            keysReady = false;
+            established = false;
+            needsHello = false;
+            for (uint8_t i = 0; i < 8; i++) {
+                localNonce[i] = 0;
+                peerNonce[i] = 0;
+            }
+            for (uint8_t i = 0; i < SchreinChaChaPoly::KEY_SIZE; i++) {
+                txKey[i] = 0;
+                rxKey[i] = 0;
+            }
+            txSequence = 0;
+            rxHighest = 0;
+            rxWindow = 0;
+            lastHelloTime = 0;
+        }
+    };
+
+    // Contexte d'émission d'un transfert en masse
+    // Protocole : "$BEGIN:<taille>:<crc32>" -> "$ACK:<offset>", "$BLK:<offset>:<hexa>",
+    // "$END:<taille>:<crc32>" -> "$CRC:OK" ou "$CRC:FAIL"
+    // Le CRC32 du contenu, calculé avant la négociation, identifie le transfert :
+    // le récepteur ne reprend que le même contenu, et repart de 0 sinon.
+    struct BulkTransferContext {
+        bool isActive = false;
+        bool needsHandshake = false;   // (Re)négocier l'offset de reprise
+        bool awaitingHandshake = false;
+        bool endSent = false;
+        uint32_t totalSize = 0;
+        uint32_t ackedOffset = 0;      // Octets confirmés par le récepteur
+        uint32_t nextOffset = 0;       // Prochain octet à émettre
+        uint32_t crcOffset = 0;        // Octets déjà intégrés au CRC (passe préalable)
+        uint32_t crc = 0xFFFFFFFFUL;
+        unsigned long lastActivityTime = 0;
+        size_t (*reader)(uint32_t offset, uint8_t *buffer, size_t length) = nullptr;
+        
+        void reset() {
+            isActive = false;
+            needsHandshake = false;
+            awaitingHandshake = false;
+            endSent = false;
+            totalSize = 0;
+            ackedOffset = 0;
+            nextOffset = 0;
+            crcOffset = 0;
+            crc = 0xFFFFFFFFUL;
+            lastActivityTime = 0;
+            reader = nullptr;
+        }
+    };
+
+    // Contexte de réception d'un transfert en masse
+    struct BulkReceiveContext {
+        bool isActive = false;
+        uint32_t totalSize = 0;
+        uint32_t transferId = 0;       // CRC32 annoncé par "$BEGIN"
+        uint32_t expectedOffset = 0;
+        uint32_t crc = 0xFFFFFFFFUL;
+        uint8_t chunksSinceAck = 0;
+        uint32_t completedSize = 0;    // Dernier transfert validé (END réémis)
+        uint32_t completedCrc = 0;
+        
+        void reset() {
+            isActive = false;
+            totalSize = 0;
+            transferId = 0;
+            expectedOffset = 0;
+            crc = 0xFFFFFFFFUL;
+            chunksSinceAck = 0;
+            completedSize = 0;
+            completedCrc = 0;
+        }
+    };
+
+    SchreinBluetoothManager(Stream &btStream, Mode mode = Mode::SERVER)
+        : SchreinBluetoothManager(btStream, mode, SBM_LAYOUT()) {}
     
     // Configuration
     void setMode(Mode newMode);
@@ -98,13 +426,77 @@ public:
     unsigned long getNextRetryTime() const;
     String getRetryStatus() const;
     
+    // Trace des transitions d'état (de la plus ancienne à la plus récente)
+    uint8_t getTransitionTraceLength() const;
+    bool getTransitionTraceEntry(uint8_t index, TransitionTraceEntry &entry) const;
+    void dumpTransitionTrace(Print &output) const;
+    void clearTransitionTrace();
+    
     // Mise à jour non bloquante - à appeler dans loop()
     void loop();
     
+    // Basse consommation : loop() peut être espacé de getIdleDuration() ms
+    // (0 = travail immédiat, ULONG_MAX = rien de programmé hors réception).
+    // Le module n'est mis en veille qu'en mode client sans liaison ni
+    // connexion en cours ; toute écriture le réveille d'abord.
+    void configureLowPower(const LowPowerConfig &config);
+    LowPowerConfig getLowPowerConfig() const;
+    unsigned long getIdleDuration();
+    bool isModuleAwake() const;
+    PowerStats getPowerStats() const;
+    void resetPowerStats();
+    void onModulePower(void (*callback)(bool awake));
+    
     // Envoi de données brutes
     bool sendRawData(const String &data);
+    bool sendRawData(const uint8_t *data, size_t length);
     bool sendRawDataWithRetry(const String &data);
     
+    // Stockage et réémission des messages produits hors connexion
+    void setOfflineQueue(SchreinOfflineQueue *queue);
+    uint32_t getOfflinePendingCount() const;
+    
+    // Session sécurisée par clé pré-partagée (ChaCha20-Poly1305).
+    // Exige setRandomSource() au préalable (aléa de poignée de main) ; renvoie
+    // false sinon. Seuls sendSecure() et la réception "!S:" sont chiffrés : les
+    // canaux, le transfert en masse, les files par pair, la vidange hors ligne
+    // et sendRawData() restent en clair. requireSecure rejette les lignes reçues
+    // en clair, ce qui coupe aussi la réception de ces chemins.
+    bool enableSecureSession(const uint8_t *presharedKey, bool requireSecure = false);
+    void disableSecureSession();
+    bool isSecureSessionEstablished() const;
+    bool sendSecure(uint8_t *data, size_t length);  // Chiffre data en place
+    bool sendSecure(const String &data);
+    unsigned long getSecureRejectedFrames() const;
+    void setRandomSource(void (*source)(uint8_t *buffer, size_t length));
+    
+    // Sessions multi-pairs (mode serveur)
+    bool sendToPeer(const String &address, const String &data);
+    bool setActivePeer(const String &address);
+    String getActivePeerAddress() const;
+    const PeerSession *getPeerSession(const String &address) const;
+    uint8_t getPeerCount() const;
+    unsigned long getEvictedPeerFrames() const;  // Messages perdus au recyclage d'une session
+    void forgetPeer(const String &address);
+    void onPeerConnect(void (*callback)(String address, bool resumed));
+    
+    // Canaux logiques avec priorités
+    bool openChannel(uint8_t channel, uint8_t priority = 1);
+    void closeChannel(uint8_t channel);
+    bool sendOnChannel(uint8_t channel, const String &data);
+    uint8_t getChannelQueueLength(uint8_t channel) const;
+    unsigned long getChannelDroppedFrames(uint8_t channel) const;
+    void onChannelData(uint8_t channel, void (*callback)(String data));
+    
+    // Transfert en masse par blocs (RAM constante quelle que soit la taille)
+    bool startBulkTransfer(uint32_t totalSize, size_t (*reader)(uint32_t offset, uint8_t *buffer, size_t length));
+    void cancelBulkTransfer();
+    bool isBulkTransferActive() const;
+    uint32_t getBulkTransferOffset() const;
+    void onBulkTransferComplete(void (*callback)(bool success, uint32_t totalSize));
+    void onBulkDataReceived(bool (*writer)(uint32_t offset, const uint8_t *data, size_t length));
+    void onBulkReceiveComplete(void (*callback)(bool success, uint32_t totalSize));
+    
     // Gestion du PIN
     bool setPin(String newPin);
     String getPin();
@@ -116,6 +508,22 @@ public:
     String getModuleName(bool forceRefresh = false);
     bool refreshModuleInfo(unsigned long timeout = 5000);
     
+    // Capture du lien série (SBM_CAPTURE_SIZE > 0), rejouable par SchreinCaptureReplay
+    bool startCapture();
+    void stopCapture();
+    size_t getCaptureSize() const;
+    void dumpCapture(Print &output) const;
+    
+#if SBM_ENABLE_METRICS
+    // Mesures de performance, exportables en JSON
+    const LinkMetrics &getMetrics() const;
+    void resetMetrics();
+    void printMetricsJson(Print &output) const;
+#endif
+    
+    // Diagnostic : vérifie la cohérence de l'état interne (bancs de fuzzing)
+    bool checkInvariants() const;
+    
     // Callbacks pour les événements
     void onConnect(void (*callback)());
     void onDisconnect(void (*callback)());
@@ -126,12 +534,20 @@ public:
     void onRetrySuccess(void (*callback)(uint8_t totalAttempts));
 
 private:
+    // Constructeur réel, signé par la configuration de la bibliothèque
+    SchreinBluetoothManager(Stream &btStream, Mode mode, SBM_LAYOUT);
+    
     // Configuration et contextes de retry
     RetryConfig retryConfig;
     RetryContext connectionRetryContext;
     RetryContext sendRetryContext;
     RetryContext atRetryContext;
 
+    // Capture intercalée devant le port série
+#if SBM_CAPTURE_SIZE > 0
+    SchreinLinkCapture linkCapture;
+#endif
+
     // Référence au port série utilisé
     Stream &btStream;
     
@@ -160,6 +576,59 @@ private:
     void (*onRetryAttemptCallback)(uint8_t attempt, uint8_t maxAttempts) = nullptr;
     void (*onRetryFailedCallback)(String reason) = nullptr;
     void (*onRetrySuccessCallback)(uint8_t totalAttempts) = nullptr;
+    void (*onModulePowerCallback)(bool awake) = nullptr;
+    void (*onPeerConnectCallback)(String address, bool resumed) = nullptr;
+    void (*randomSource)(uint8_t *buffer, size_t length) = nullptr;
+    void (*onBulkTransferCompleteCallback)(bool success, uint32_t totalSize) = nullptr;
+    bool (*onBulkDataReceivedCallback)(uint32_t offset, const uint8_t *data, size_t length) = nullptr;
+    void (*onBulkReceiveCompleteCallback)(bool success, uint32_t totalSize) = nullptr;
+    
+#if SBM_ENABLE_METRICS
+    // Mesures de performance (absentes de la RAM sinon)
+    LinkMetrics metrics;
+    unsigned long sendRetryQueuedMicros = 0;
+#endif
+    
+    // Basse consommation
+    LowPowerConfig lowPowerConfig;
+    PowerStats powerStats;
+    bool moduleAwake = true;
+    unsigned long lastPowerTransition = 0;
+    unsigned long nextBurstTime = 0;
+    
+    // Machine à états de connexion
+    struct StateTransition {
+        ConnectionState from;
+        ConnectionEvent event;
+        ConnectionState to;
+        bool (SchreinBluetoothManager::*guard)() const;
+    };
+    static const StateTransition stateTransitionTable[];
+    
+    TransitionTraceEntry transitionTrace[SBM_TRACE_SIZE];
+    uint8_t transitionTraceHead = 0;
+    uint8_t transitionTraceCount = 0;
+    
+    // Session sécurisée (tampon de trame chiffrée en place)
+    SecureSessionContext secureSession;
+    uint8_t presharedKey[SchreinChaChaPoly::KEY_SIZE];
+    uint8_t secureBuffer[SBM_SECURE_MAX_PAYLOAD + SBM_SECURE_OVERHEAD + 1];
+    
+    // File hors connexion (fournie par l'application)
+    SchreinOfflineQueue *offlineQueue = nullptr;
+    
+    // Sessions des pairs (mode serveur)
+    PeerSession peerSessions[SBM_MAX_PEERS];
+    int8_t activePeer = -1;
+    unsigned long evictedPeerFrames = 0;
+    
+    // Canaux logiques
+    Channel channels[SBM_MAX_CHANNELS];
+    
+    // Transfert en masse (un seul tampon de bloc partagé émission/réception)
+    BulkTransferContext bulkTransferContext;
+    BulkReceiveContext bulkReceiveContext;
+    uint8_t bulkBuffer[SBM_BULK_CHUNK_SIZE];
     
     // Méthodes de retry
     void processConnectionRetry();
@@ -172,6 +641,11 @@ private:
     void resetAllRetryContexts();
     
     // Méthodes internes
+    bool dispatchConnectionEvent(ConnectionEvent event);
+    bool guardClientMode() const;
+    bool guardConnectionRetryEnabled() const;
+    void recordTransition(ConnectionEvent event, ConnectionState fromState,
+                          ConnectionState toState, bool accepted);
     void changeConnectionState(ConnectionState newState);
     void processBluetoothCommands();
     bool sendATCommand(String command, String expectedResponse = "OK", unsigned long timeout = 1000);
@@ -181,9 +655,65 @@ private:
     String readATResponse(unsigned long timeout);
     bool waitForResponse(String expectedResponse, unsigned long timeout = 1000);
     String parseMacAddress(String rawResponse);
+    void appendToMatchWindow(String &window, char c, unsigned int keep);
     
     // Gestion des données entrantes
-    void processIncomingData();
+    void dispatchReceivedData(const String &data);
+    void routeReceivedData(const String &data);
+    size_t decodeHex(const String &text, unsigned int start, uint8_t *output, size_t maxLength);
+    
+    // Session sécurisée
+    void processSecureSession();
+    void startSecureHandshake();
+    void sendSecureHello();
+    void handleSecureHello(const String &frame);
+    void handleSecureFrame(const String &frame);
+    bool transmitSecureFrame(uint8_t *data, size_t length);
+    
+    // Émission brute et file hors connexion
+    void transmitRawLine(const uint8_t *data, size_t length);
+    void finishRawLine(size_t length);
+    bool shouldStoreOffline() const;
+    bool storeOffline(const uint8_t *data, size_t length);
+    void processOfflineQueue();
+    
+    // Sessions des pairs
+    int8_t findPeer(const uint8_t *address) const;
+    int8_t acquirePeer(const uint8_t *address);
+    void activatePeer(const String &address);
+    void processPeerQueue();
+    static bool macToBytes(const String &address, uint8_t *bytes);
+    static String macToString(const uint8_t *bytes);
+    
+    // Ordonnancement des canaux
+    void processChannelScheduler();
+    void resetAllChannels();
+    
+#if SBM_ENABLE_METRICS
+    // Mesures de performance
+    void recordMetrics(PathMetrics &path, unsigned long startMicros, size_t bytes);
+    void printPathMetricsJson(Print &output, const char *name, const PathMetrics &path) const;
+#endif
+    
+    // Basse consommation
+    void updatePowerState(bool wakeOnly);
+    void setModulePower(bool awake);
+    bool canModuleSleep() const;
+    void wakeModule();
+    static unsigned long remainingUntil(unsigned long deadline, unsigned long now);
+    
+    // Transfert en masse
+    void processBulkTransfer();
+    void hashBulkContent();
+    bool handleBulkFrame(const String &frame);
+    void handleBulkAck(uint32_t offset);
+    void handleBulkBlock(const String &frame, int separator);
+    void handleBulkEnd(const String &frame);
+    void finishBulkTransfer(bool success);
+    void sendBulkAck();
+    void printHex(const uint8_t *data, size_t length);
+    void printCrc32(uint32_t crc);
+    static uint32_t updateCrc32(uint32_t crc, const uint8_t *data, size_t length);
 };
 
 #endif
\ No newline at end of file
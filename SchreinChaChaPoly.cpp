@@ -0,0 +1,195 @@
+#include "SchreinChaChaPoly.h"
+
+#define SBM_ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define SBM_QUARTER_ROUND(a, b, c, d) \
+    a += b; d ^= a; d = SBM_ROTL32(d, 16); \
+    c += d; b ^= c; b = SBM_ROTL32(b, 12); \
+    a += b; d ^= a; d = SBM_ROTL32(d, 8);  \
+    c += d; b ^= c; b = SBM_ROTL32(b, 7)
+
+static uint32_t load32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void store32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+void SchreinChaChaPoly::block(const uint8_t *key, const uint8_t *input, uint8_t *output) {
+    uint32_t state[16] = {
+        0x61707865UL, 0x3320646eUL, 0x79622d32UL, 0x6b206574UL
+    };
+    for (uint8_t i = 0; i < 8; i++) {
+        state[4 + i] = load32(key + 4 * i);
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        state[12 + i] = load32(input + 4 * i);
+    }
+    
+    uint32_t x[16];
+    for (uint8_t i = 0; i < 16; i++) {
+        x[i] = state[i];
+    }
+    
+    for (uint8_t round = 0; round < 10; round++) {
+        SBM_QUARTER_ROUND(x[0], x[4], x[8],  x[12]);
+        SBM_QUARTER_ROUND(x[1], x[5], x[9],  x[13]);
+        SBM_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        SBM_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        SBM_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        SBM_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        SBM_QUARTER_ROUND(x[2], x[7], x[8],  x[13]);
+        SBM_QUARTER_ROUND(x[3], x[4], x[9],  x[14]);
+    }
+    
+    for (uint8_t i = 0; i < 16; i++) {
+        store32(output + 4 * i, x[i] + state[i]);
+    }
+}
+
+void SchreinChaChaPoly::chacha20Xor(const uint8_t *key, const uint8_t *nonce, uint32_t counter,
+                                    uint8_t *data, size_t length) {
+    uint8_t input[16];
+    uint8_t keystream[64];
+    for (uint8_t i = 0; i < NONCE_SIZE; i++) {
+        input[4 + i] = nonce[i];
+    }
+    
+    for (size_t offset = 0; offset < length; offset += 64) {
+        store32(input, counter++);
+        block(key, input, keystream);
+        
+        size_t chunk = length - offset < 64 ? length - offset : 64;
+        for (size_t i = 0; i < chunk; i++) {
+            data[offset + i] ^= keystream[i];
+        }
+    }
+}
+
+void SchreinChaChaPoly::computeTag(const uint8_t *key, const uint8_t *nonce,
+                                   const uint8_t *aad, size_t aadLength,
+                                   const uint8_t *data, size_t length, uint8_t *tag) {
+    // Clé Poly1305 : 32 premiers octets du bloc de compteur 0
+    uint8_t polyKey[64];
+    uint8_t input[16] = {0};
+    for (uint8_t i = 0; i < NONCE_SIZE; i++) {
+        input[4 + i] = nonce[i];
+    }
+    block(key, input, polyKey);
+    
+    // Poly1305 en limbes de 26 bits (produits 32x32 -> 64)
+    uint32_t r0 = load32(polyKey) & 0x3ffffff;
+    uint32_t r1 = (load32(polyKey + 3) >> 2) & 0x3ffff03;
+    uint32_t r2 = (load32(polyKey + 6) >> 4) & 0x3ffc0ff;
+    uint32_t r3 = (load32(polyKey + 9) >> 6) & 0x3f03fff;
+    uint32_t r4 = (load32(polyKey + 12) >> 8) & 0x00fffff;
+    uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = 0, h1 = 0, h2 = 0, h3 = 0, h4 = 0;
+    
+    // Message : aad || bourrage || data || bourrage || longueurs (8 octets LE chacune)
+    uint8_t lengths[16] = {0};
+    store32(lengths, (uint32_t)aadLength);
+    store32(lengths + 8, (uint32_t)length);
+    
+    const uint8_t *segments[3] = { aad, data, lengths };
+    size_t segmentLengths[3] = { aadLength, length, 16 };
+    
+    for (uint8_t segment = 0; segment < 3; segment++) {
+        const uint8_t *message = segments[segment];
+        size_t remaining = segmentLengths[segment];
+        
+        while (remaining > 0) {
+            uint8_t blockData[16] = {0};
+            size_t chunk = remaining < 16 ? remaining : 16;
+            for (size_t i = 0; i < chunk; i++) {
+                blockData[i] = message[i];
+            }
+            message += chunk;
+            remaining -= chunk;
+            
+            // Blocs complétés par des zéros : le bit 2^128 est toujours présent
+            h0 += load32(blockData) & 0x3ffffff;
+            h1 += (load32(blockData + 3) >> 2) & 0x3ffffff;
+            h2 += (load32(blockData + 6) >> 4) & 0x3ffffff;
+            h3 += (load32(blockData + 9) >> 6) & 0x3ffffff;
+            h4 += (load32(blockData + 12) >> 8) | (1UL << 24);
+            
+            uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+            uint64_t d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+            uint64_t d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 + (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+            uint64_t d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 + (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+            uint64_t d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 + (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+            
+            uint32_t carry;
+            carry = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & 0x3ffffff;
+            d1 += carry; carry = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & 0x3ffffff;
+            d2 += carry; carry = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & 0x3ffffff;
+            d3 += carry; carry = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & 0x3ffffff;
+            d4 += carry; carry = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & 0x3ffffff;
+            h0 += carry * 5; carry = h0 >> 26; h0 &= 0x3ffffff;
+            h1 += carry;
+        }
+    }
+    
+    // Réduction complète modulo 2^130 - 5
+    uint32_t carry;
+    carry = h1 >> 26; h1 &= 0x3ffffff;
+    h2 += carry; carry = h2 >> 26; h2 &= 0x3ffffff;
+    h3 += carry; carry = h3 >> 26; h3 &= 0x3ffffff;
+    h4 += carry; carry = h4 >> 26; h4 &= 0x3ffffff;
+    h0 += carry * 5; carry = h0 >> 26; h0 &= 0x3ffffff;
+    h1 += carry;
+    
+    uint32_t g0 = h0 + 5; carry = g0 >> 26; g0 &= 0x3ffffff;
+    uint32_t g1 = h1 + carry; carry = g1 >> 26; g1 &= 0x3ffffff;
+    uint32_t g2 = h2 + carry; carry = g2 >> 26; g2 &= 0x3ffffff;
+    uint32_t g3 = h3 + carry; carry = g3 >> 26; g3 &= 0x3ffffff;
+    uint32_t g4 = h4 + carry - (1UL << 26);
+    
+    uint32_t mask = (g4 >> 31) - 1;   // h >= p : garder g
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+    
+    // tag = (h + s) mod 2^128
+    uint64_t f;
+    f = (uint64_t)(h0 | (h1 << 26)) + load32(polyKey + 16);
+    store32(tag, (uint32_t)f);
+    f = (uint64_t)((h1 >> 6) | (h2 << 20)) + load32(polyKey + 20) + (f >> 32);
+    store32(tag + 4, (uint32_t)f);
+    f = (uint64_t)((h2 >> 12) | (h3 << 14)) + load32(polyKey + 24) + (f >> 32);
+    store32(tag + 8, (uint32_t)f);
+    f = (uint64_t)((h3 >> 18) | (h4 << 8)) + load32(polyKey + 28) + (f >> 32);
+    store32(tag + 12, (uint32_t)f);
+}
+
+void SchreinChaChaPoly::encrypt(const uint8_t *key, const uint8_t *nonce,
+                                const uint8_t *aad, size_t aadLength,
+                                uint8_t *data, size_t length, uint8_t *tag) {
+    chacha20Xor(key, nonce, 1, data, length);
+    computeTag(key, nonce, aad, aadLength, data, length, tag);
+}
+
+bool SchreinChaChaPoly::decrypt(const uint8_t *key, const uint8_t *nonce,
+                                const uint8_t *aad, size_t aadLength,
+                                uint8_t *data, size_t length, const uint8_t *tag) {
+    uint8_t expected[TAG_SIZE];
+    computeTag(key, nonce, aad, aadLength, data, length, expected);
+    
+    // Comparaison en temps constant
+    uint8_t difference = 0;
+    for (uint8_t i = 0; i < TAG_SIZE; i++) {
+        difference |= expected[i] ^ tag[i];
+    }
+    if (difference != 0) return false;
+    
+    chacha20Xor(key, nonce, 1, data, length);
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef SCHREINCHACHAPOLY_H
+#define SCHREINCHACHAPOLY_H
+
+#include <Arduino.h>
+
+// AEAD ChaCha20-Poly1305 (RFC 8439), chiffrement en place, sans allocation.
+// Implémentation 32 bits portable (AVR, ARM, ESP) ; pas de table en RAM.
+class SchreinChaChaPoly {
+public:
+    static const uint8_t KEY_SIZE = 32;
+    static const uint8_t NONCE_SIZE = 12;
+    static const uint8_t TAG_SIZE = 16;
+
+    // Chiffre data en place et produit le tag d'authentification
+    static void encrypt(const uint8_t *key, const uint8_t *nonce,
+                        const uint8_t *aad, size_t aadLength,
+                        uint8_t *data, size_t length, uint8_t *tag);
+    
+    // Vérifie le tag puis déchiffre data en place ; data intact si échec
+    static bool decrypt(const uint8_t *key, const uint8_t *nonce,
+                        const uint8_t *aad, size_t aadLength,
+                        uint8_t *data, size_t length, const uint8_t *tag);
+    
+    // Bloc ChaCha20 brut : input = compteur (4 octets LE) || nonce (12 octets)
+    static void block(const uint8_t *key, const uint8_t *input, uint8_t *output);
+
+private:
+    static void chacha20Xor(const uint8_t *key, const uint8_t *nonce, uint32_t counter,
+                            uint8_t *data, size_t length);
+    static void computeTag(const uint8_t *key, const uint8_t *nonce,
+                           const uint8_t *aad, size_t aadLength,
+                           const uint8_t *data, size_t length, uint8_t *tag);
+};
+
+#endif
@@ -0,0 +1,278 @@
+#include "SchreinLinkCapture.h"
+
+SchreinLinkCapture::SchreinLinkCapture(Stream &inner)
+    : inner(inner),
+      capturing(false) {
+    clear();
+}
+
+void SchreinLinkCapture::start() {
+    // Chaque démarrage ouvre une nouvelle capture
+    clear();
+    capturing = true;
+}
+
+void SchreinLinkCapture::stop() {
+    capturing = false;
+}
+
+void SchreinLinkCapture::clear() {
+#if SBM_CAPTURE_SIZE > 0
+    head = 0;
+    count = 0;
+    currentHeader = -1;
+    currentType = RECORD_RX;
+    baseTimestamp = millis();
+    lastTimestamp = baseTimestamp;
+#endif
+}
+
+bool SchreinLinkCapture::isCapturing() const {
+    return capturing;
+}
+
+size_t SchreinLinkCapture::size() const {
+#if SBM_CAPTURE_SIZE > 0
+    return count;
+#else
+    return 0;
+#endif
+}
+
+void SchreinLinkCapture::recordEvent(uint8_t code) {
+#if SBM_CAPTURE_SIZE > 0
+    record(RECORD_EVENT, code);
+#else
+    (void)code;
+#endif
+}
+
+void SchreinLinkCapture::dump(Print &output) const {
+#if SBM_CAPTURE_SIZE > 0
+    uint8_t header[9] = {
+        'S', 'B', 'M', 'C', FORMAT_VERSION,
+        (uint8_t)baseTimestamp, (uint8_t)(baseTimestamp >> 8),
+        (uint8_t)(baseTimestamp >> 16), (uint8_t)(baseTimestamp >> 24)
+    };
+    output.write(header, sizeof(header));
+    
+    // Deux segments au plus selon le repli du tampon circulaire
+    size_t firstLength = min(count, (size_t)SBM_CAPTURE_SIZE - head);
+    output.write(buffer + head, firstLength);
+    if (firstLength < count) {
+        output.write(buffer, count - firstLength);
+    }
+#else
+    (void)output;
+#endif
+}
+
+int SchreinLinkCapture::available() {
+    return inner.available();
+}
+
+int SchreinLinkCapture::read() {
+    int c = inner.read();
+#if SBM_CAPTURE_SIZE > 0
+    if (c >= 0) record(RECORD_RX, (uint8_t)c);
+#endif
+    return c;
+}
+
+int SchreinLinkCapture::peek() {
+    return inner.peek();
+}
+
+size_t SchreinLinkCapture::write(uint8_t c) {
+#if SBM_CAPTURE_SIZE > 0
+    record(RECORD_TX, c);
+#endif
+    return inner.write(c);
+}
+
+size_t SchreinLinkCapture::write(const uint8_t *data, size_t length) {
+#if SBM_CAPTURE_SIZE > 0
+    for (size_t i = 0; i < length; i++) {
+        record(RECORD_TX, data[i]);
+    }
+#endif
+    return inner.write(data, length);
+}
+
+void SchreinLinkCapture::flush() {
+    inner.flush();
+}
+
+#if SBM_CAPTURE_SIZE > 0
+void SchreinLinkCapture::record(uint8_t type, uint8_t value) {
+    if (!capturing) return;
+    
+    unsigned long now = millis();
+    
+    // Prolonger l'enregistrement courant si même type et même milliseconde
+    if (currentHeader >= 0 && currentType == type && now == lastTimestamp &&
+        (buffer[currentHeader] & 0x3F) < MAX_RECORD_LENGTH - 1) {
+        if (ensureSpace(1) && currentHeader >= 0) {
+            pushByte(value);
+            buffer[currentHeader]++;
+            return;
+        }
+    }
+    
+    unsigned long delta = now - lastTimestamp;
+    uint8_t varintLength = 1;
+    for (unsigned long rest = delta >> 7; rest != 0; rest >>= 7) {
+        varintLength++;
+    }
+    if (!ensureSpace(2 + varintLength)) return;
+    
+    currentHeader = (head + count) % SBM_CAPTURE_SIZE;
+    currentType = type;
+    pushByte(type << 6);
+    while (delta >= 0x80) {
+        pushByte((uint8_t)(delta & 0x7F) | 0x80);
+        delta >>= 7;
+    }
+    pushByte((uint8_t)delta);
+    pushByte(value);
+    lastTimestamp = now;
+}
+
+bool SchreinLinkCapture::ensureSpace(size_t length) {
+    if (length > SBM_CAPTURE_SIZE) return false;
+    
+    while (SBM_CAPTURE_SIZE - count < length) {
+        evictOldest();
+    }
+    return true;
+}
+
+void SchreinLinkCapture::evictOldest() {
+    // Le delta du plus ancien enregistrement est reporté sur la base
+    uint8_t header = byteAt(0);
+    size_t offset = 1;
+    unsigned long delta = 0;
+    uint8_t shift = 0;
+    uint8_t value;
+    do {
+        value = byteAt(offset++);
+        delta |= (unsigned long)(value & 0x7F) << shift;
+        shift += 7;
+    } while (value & 0x80);
+    
+    size_t total = offset + (header & 0x3F) + 1;
+    if ((long)head == currentHeader) {
+        currentHeader = -1;
+    }
+    
+    baseTimestamp += delta;
+    head = (head + total) % SBM_CAPTURE_SIZE;
+    count -= total;
+}
+
+void SchreinLinkCapture::pushByte(uint8_t value) {
+    buffer[(head + count) % SBM_CAPTURE_SIZE] = value;
+    count++;
+}
+
+uint8_t SchreinLinkCapture::byteAt(size_t offset) const {
+    return buffer[(head + offset) % SBM_CAPTURE_SIZE];
+}
+#endif
+
+SchreinCaptureReplay::SchreinCaptureReplay(const uint8_t *capture, size_t length, uint16_t speedFactor)
+    : capture(capture),
+      length(length),
+      speedFactor(speedFactor) {
+    valid = length >= 9 && capture[0] == 'S' && capture[1] == 'B' &&
+            capture[2] == 'M' && capture[3] == 'C' &&
+            capture[4] == SchreinLinkCapture::FORMAT_VERSION;
+    restart();
+}
+
+void SchreinCaptureReplay::restart() {
+    position = 9;
+    recordType = SchreinLinkCapture::RECORD_RX;
+    recordRemaining = 0;
+    recordTime = 0;
+    startTime = millis();
+    bytesReplayed = 0;
+    bytesWritten = 0;
+}
+
+bool SchreinCaptureReplay::isFinished() {
+    return !valid || (recordRemaining == 0 && !nextRxRecord());
+}
+
+bool SchreinCaptureReplay::isValid() const {
+    return valid;
+}
+
+unsigned long SchreinCaptureReplay::getBytesReplayed() const {
+    return bytesReplayed;
+}
+
+unsigned long SchreinCaptureReplay::getBytesWritten() const {
+    return bytesWritten;
+}
+
+int SchreinCaptureReplay::available() {
+    if (!valid) return 0;
+    if (recordRemaining == 0 && !nextRxRecord()) return 0;
+    
+    // Respecter l'horodatage d'origine, accéléré de speedFactor
+    if (speedFactor > 0 && recordTime / speedFactor > millis() - startTime) {
+        return 0;
+    }
+    return recordRemaining;
+}
+
+int SchreinCaptureReplay::read() {
+    if (available() <= 0) return -1;
+    
+    recordRemaining--;
+    bytesReplayed++;
+    return capture[position++];
+}
+
+int SchreinCaptureReplay::peek() {
+    if (available() <= 0) return -1;
+    return capture[position];
+}
+
+size_t SchreinCaptureReplay::write(uint8_t c) {
+    // Les émissions du code rejoué sont seulement comptées
+    (void)c;
+    bytesWritten++;
+    return 1;
+}
+
+bool SchreinCaptureReplay::nextRxRecord() {
+    // Avancer jusqu'au prochain enregistrement RX en cumulant les deltas
+    while (position < length) {
+        uint8_t header = capture[position++];
+        uint8_t recordLength = (header & 0x3F) + 1;
+        
+        unsigned long delta = 0;
+        uint8_t shift = 0;
+        uint8_t value = 0x80;
+        while ((value & 0x80) && position < length && shift < 32) {
+            value = capture[position++];
+            delta |= (unsigned long)(value & 0x7F) << shift;
+            shift += 7;
+        }
+        recordTime += delta;
+        
+        if (position + recordLength > length) break;
+        
+        recordType = header >> 6;
+        if (recordType == SchreinLinkCapture::RECORD_RX) {
+            recordRemaining = recordLength;
+            return true;
+        }
+        position += recordLength;
+    }
+    
+    position = length;
+    return false;
+}
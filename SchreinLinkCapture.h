@@ -0,0 +1,107 @@
+#ifndef SCHREINLINKCAPTURE_H
+#define SCHREINLINKCAPTURE_H
+
+#include <Arduino.h>
+
+// Taille du tampon de capture en octets (0 = capture désactivée, option -D uniquement)
+#ifndef SBM_CAPTURE_SIZE
+#define SBM_CAPTURE_SIZE 0
+#endif
+
+// Format d'une capture (dump) :
+//   "SBMC", version (1 octet), horodatage de base (uint32 LE), puis des
+//   enregistrements : en-tête (type << 6 | longueur - 1), delta en ms depuis
+//   l'enregistrement précédent (varint LEB128), puis 1 à 64 octets de données.
+//   Les octets consécutifs de même type et de même milliseconde sont regroupés.
+
+// Capture des octets RX/TX du lien série, intercalée devant le vrai Stream
+class SchreinLinkCapture : public Stream {
+public:
+    enum RecordType : uint8_t {
+        RECORD_RX = 0,       // Octets reçus du module
+        RECORD_TX = 1,       // Octets émis vers le module
+        RECORD_EVENT = 2     // Événement d'état (un code par octet)
+    };
+
+    static const uint8_t FORMAT_VERSION = 1;
+    static const uint8_t MAX_RECORD_LENGTH = 64;
+
+    SchreinLinkCapture(Stream &inner);
+    
+    // Contrôle de la capture
+    void start();
+    void stop();
+    void clear();
+    bool isCapturing() const;
+    size_t size() const;
+    void recordEvent(uint8_t code);
+    void dump(Print &output) const;
+    
+    // Interface Stream (transmise au port réel)
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t length) override;
+    void flush() override;
+    using Print::write;
+
+private:
+    Stream &inner;
+    bool capturing;
+    
+#if SBM_CAPTURE_SIZE > 0
+    // Tampon circulaire d'enregistrements de longueur variable
+    uint8_t buffer[SBM_CAPTURE_SIZE];
+    size_t head;                 // Premier octet du plus ancien enregistrement
+    size_t count;
+    long currentHeader;          // Index de l'en-tête extensible, -1 sinon
+    uint8_t currentType;
+    unsigned long baseTimestamp; // Référence du delta du plus ancien enregistrement
+    unsigned long lastTimestamp;
+    
+    void record(uint8_t type, uint8_t value);
+    bool ensureSpace(size_t length);
+    void evictOldest();
+    void pushByte(uint8_t value);
+    uint8_t byteAt(size_t offset) const;
+#endif
+};
+
+// Rejoue une capture comme un Stream : les octets RX sont délivrés à leur
+// horodatage d'origine, divisé par speedFactor (0 = sans attente)
+class SchreinCaptureReplay : public Stream {
+public:
+    SchreinCaptureReplay(const uint8_t *capture, size_t length, uint16_t speedFactor = 1);
+    
+    void restart();
+    bool isFinished();
+    bool isValid() const;
+    unsigned long getBytesReplayed() const;
+    unsigned long getBytesWritten() const;
+    
+    // Interface Stream
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+private:
+    const uint8_t *capture;
+    size_t length;
+    uint16_t speedFactor;
+    bool valid;
+    
+    size_t position;             // Prochain octet à lire dans la capture
+    uint8_t recordType;
+    uint8_t recordRemaining;     // Octets restants dans l'enregistrement courant
+    unsigned long recordTime;    // Horodatage relatif de l'enregistrement courant
+    unsigned long startTime;
+    unsigned long bytesReplayed;
+    unsigned long bytesWritten;
+    
+    bool nextRxRecord();
+};
+
+#endif
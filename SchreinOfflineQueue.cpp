@@ -0,0 +1,285 @@
+#include "SchreinOfflineQueue.h"
+
+#define SBM_OFFLINE_MAGIC 0xA5
+#define SBM_OFFLINE_PENDING 0xFF
+#define SBM_OFFLINE_CONSUMED 0x00
+
+SchreinRamStorage::SchreinRamStorage(uint8_t *buffer, uint32_t size, uint32_t pageSize)
+    : buffer(buffer),
+      size(pageSize ? size - size % pageSize : 0),
+      page(pageSize) {
+}
+
+uint32_t SchreinRamStorage::capacity() const {
+    return size;
+}
+
+uint32_t SchreinRamStorage::pageSize() const {
+    return page;
+}
+
+bool SchreinRamStorage::read(uint32_t address, uint8_t *data, size_t length) {
+    if (address + length > size) return false;
+    memcpy(data, buffer + address, length);
+    return true;
+}
+
+bool SchreinRamStorage::write(uint32_t address, const uint8_t *data, size_t length) {
+    if (address + length > size) return false;
+    memcpy(buffer + address, data, length);
+    return true;
+}
+
+bool SchreinRamStorage::erase(uint32_t index) {
+    if ((index + 1) * page > size) return false;
+    memset(buffer + index * page, 0xFF, page);
+    return true;
+}
+
+SchreinOfflineQueue::SchreinOfflineQueue(SchreinOfflineStorage &storage)
+    : storage(storage),
+      head(0),
+      headPage(0),
+      tail(0),
+      pendingCount(0),
+      droppedCount(0),
+      nextSequence(1) {
+}
+
+bool SchreinOfflineQueue::begin() {
+    uint32_t pageSize = storage.pageSize();
+    if (pageSize <= HEADER_SIZE || storage.capacity() / pageSize < 2) return false;
+    uint32_t pageCount = storage.capacity() / pageSize;
+    
+    // Chaque page est lue d'un enregistrement au suivant jusqu'au premier
+    // en-tête invalide : au-delà, elle est vierge ou porte une écriture interrompue
+    bool found = false;
+    uint32_t maxSequence = 0;
+    uint32_t minPendingSequence = 0xFFFFFFFFUL;
+    
+    pendingCount = 0;
+    head = 0;
+    headPage = 0;
+    tail = 0;
+    
+    for (uint32_t page = 0; page < pageCount; page++) {
+        uint32_t address = page * pageSize;
+        uint32_t pageEnd = address + pageSize;
+        uint32_t sequence;
+        uint16_t length;
+        bool pending;
+        
+        while (address + HEADER_SIZE <= pageEnd &&
+               readHeader(address, sequence, length, pending) &&
+               address + HEADER_SIZE + length <= pageEnd) {
+            uint32_t end = address + HEADER_SIZE + length;
+            
+            // Reprise après le plus récent, même consommé : sa zone est déjà écrite
+            if (!found || sequence > maxSequence) {
+                found = true;
+                maxSequence = sequence;
+                head = end;
+                headPage = page;
+            }
+            if (pending) {
+                pendingCount++;
+                if (sequence < minPendingSequence) {
+                    minPendingSequence = sequence;
+                    tail = address;
+                }
+            }
+            address = end;
+        }
+    }
+    
+    nextSequence = maxSequence + 1;
+    if (pendingCount == 0) tail = head;
+    
+    // Fin de page non vierge (coupure pendant une écriture, support jamais
+    // effacé) : on ne peut plus y écrire, passer à la page suivante
+    if (!isErased(head, (headPage + 1) * pageSize)) {
+        return openNextPage();
+    }
+    return true;
+}
+
+void SchreinOfflineQueue::clear() {
+    while (pendingCount > 0) {
+        pop();
+    }
+}
+
+bool SchreinOfflineQueue::push(const uint8_t *data, size_t length) {
+    if (length == 0 || length > getMaxRecordLength()) return false;
+    
+    // Jamais à cheval sur deux pages
+    uint32_t recordSize = HEADER_SIZE + length;
+    if (head + recordSize > (headPage + 1) * storage.pageSize() && !openNextPage()) {
+        return false;
+    }
+    
+    uint32_t sequence = nextSequence;
+    uint8_t header[HEADER_SIZE] = {
+        SBM_OFFLINE_MAGIC, SBM_OFFLINE_PENDING,
+        (uint8_t)sequence, (uint8_t)(sequence >> 8),
+        (uint8_t)(sequence >> 16), (uint8_t)(sequence >> 24),
+        (uint8_t)length, (uint8_t)(length >> 8), 0
+    };
+    header[8] = crc8(header + 2, 6);
+    
+    // Données d'abord, en-tête ensuite : l'en-tête valide l'enregistrement
+    if (!storage.write(head + HEADER_SIZE, data, length) ||
+        !storage.write(head, header, HEADER_SIZE)) {
+        // Zone peut-être entamée : ne plus rien écrire dans cette page
+        head = (headPage + 1) * storage.pageSize();
+        return false;
+    }
+    
+    if (pendingCount == 0) tail = head;
+    head += recordSize;
+    pendingCount++;
+    nextSequence++;
+    return true;
+}
+
+size_t SchreinOfflineQueue::peek(uint8_t *buffer, size_t maxLength) {
+    size_t length = peekLength();
+    if (length == 0 || length > maxLength) return 0;
+    return storage.read(tail + HEADER_SIZE, buffer, length) ? length : 0;
+}
+
+size_t SchreinOfflineQueue::peekLength() {
+    if (pendingCount == 0) return 0;
+    
+    uint32_t sequence;
+    uint16_t length;
+    bool pending;
+    if (!readHeader(tail, sequence, length, pending) || !pending) {
+        // Support modifié hors de la file : reconstruire l'état
+        begin();
+        return 0;
+    }
+    return length;
+}
+
+size_t SchreinOfflineQueue::peekChunk(size_t offset, uint8_t *buffer, size_t length) {
+    size_t total = peekLength();
+    if (offset >= total) return 0;
+    
+    if (length > total - offset) length = total - offset;
+    return storage.read(tail + HEADER_SIZE + offset, buffer, length) ? length : 0;
+}
+
+bool SchreinOfflineQueue::pop() {
+    if (pendingCount == 0) return false;
+    
+    uint8_t consumed = SBM_OFFLINE_CONSUMED;
+    storage.write(tail + 1, &consumed, 1);
+    advanceTail();
+    return true;
+}
+
+bool SchreinOfflineQueue::isEmpty() const {
+    return pendingCount == 0;
+}
+
+uint32_t SchreinOfflineQueue::getPendingCount() const {
+    return pendingCount;
+}
+
+uint32_t SchreinOfflineQueue::getDroppedCount() const {
+    return droppedCount;
+}
+
+size_t SchreinOfflineQueue::getMaxRecordLength() const {
+    uint32_t pageSize = storage.pageSize();
+    if (pageSize <= HEADER_SIZE) return 0;
+    return pageSize - HEADER_SIZE < SBM_OFFLINE_MAX_RECORD ? pageSize - HEADER_SIZE : SBM_OFFLINE_MAX_RECORD;
+}
+
+bool SchreinOfflineQueue::readHeader(uint32_t address, uint32_t &sequence, uint16_t &length, bool &pending) {
+    uint8_t header[HEADER_SIZE];
+    if (!storage.read(address, header, HEADER_SIZE)) return false;
+    
+    if (header[0] != SBM_OFFLINE_MAGIC) return false;
+    if (header[1] != SBM_OFFLINE_PENDING && header[1] != SBM_OFFLINE_CONSUMED) return false;
+    if (crc8(header + 2, 6) != header[8]) return false;
+    
+    sequence = (uint32_t)header[2] | ((uint32_t)header[3] << 8) |
+               ((uint32_t)header[4] << 16) | ((uint32_t)header[5] << 24);
+    length = (uint16_t)header[6] | ((uint16_t)header[7] << 8);
+    pending = header[1] == SBM_OFFLINE_PENDING;
+    return length > 0 && length <= SBM_OFFLINE_MAX_RECORD;
+}
+
+bool SchreinOfflineQueue::isErased(uint32_t address, uint32_t end) {
+    uint8_t chunk[16];
+    while (address < end) {
+        size_t length = end - address < sizeof(chunk) ? end - address : sizeof(chunk);
+        if (!storage.read(address, chunk, length)) return false;
+        for (size_t i = 0; i < length; i++) {
+            if (chunk[i] != 0xFF) return false;
+        }
+        address += length;
+    }
+    return true;
+}
+
+bool SchreinOfflineQueue::openNextPage() {
+    uint32_t pageSize = storage.pageSize();
+    uint32_t next = (headPage + 1) % (storage.capacity() / pageSize);
+    
+    // La page suivante porte les messages les plus anciens : les sacrifier
+    while (pendingCount > 0 && tail / pageSize == next) {
+        dropOldest();
+    }
+    if (!storage.erase(next)) return false;
+    
+    headPage = next;
+    head = next * pageSize;
+    if (pendingCount == 0) tail = head;
+    return true;
+}
+
+void SchreinOfflineQueue::dropOldest() {
+    if (pop()) {
+        droppedCount++;
+    }
+}
+
+void SchreinOfflineQueue::advanceTail() {
+    uint32_t sequence;
+    uint16_t length = 0;
+    bool pending;
+    readHeader(tail, sequence, length, pending);
+    
+    pendingCount--;
+    if (pendingCount == 0) {
+        tail = head;
+        return;
+    }
+    
+    // Enregistrement suivant dans la page, sinon début de la page suivante
+    // (en sautant une page ouverte puis laissée vide par une coupure)
+    uint32_t pageSize = storage.pageSize();
+    uint32_t capacity = storage.capacity();
+    uint32_t next = tail + HEADER_SIZE + length;
+    for (uint32_t i = 0; i <= capacity / pageSize; i++) {
+        next %= capacity;
+        uint32_t pageEnd = (next / pageSize + 1) * pageSize;
+        if (next + HEADER_SIZE <= pageEnd && readHeader(next, sequence, length, pending) && pending) break;
+        next = pageEnd;
+    }
+    tail = next % capacity;
+}
+
+uint8_t SchreinOfflineQueue::crc8(const uint8_t *data, size_t length) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,97 @@
+#ifndef SCHREINOFFLINEQUEUE_H
+#define SCHREINOFFLINEQUEUE_H
+
+#include <Arduino.h>
+
+// Taille maximale d'un message conservé hors connexion (option -D uniquement).
+// Bornée en outre par la taille de page du support, voir getMaxRecordLength().
+#ifndef SBM_OFFLINE_MAX_RECORD
+#define SBM_OFFLINE_MAX_RECORD 256
+#endif
+
+// Support de stockage découpé en pages effaçables (RAM, EEPROM, flash, fichier).
+// Contrat flash : une page effacée lit 0xFF, une écriture ne fait passer des
+// bits que de 1 à 0. La file n'écrit que dans des zones effacées, plus l'octet
+// d'état 0xFF -> 0x00 d'un message consommé, et efface une page entière avant
+// d'y revenir. capacity() est un multiple de pageSize().
+class SchreinOfflineStorage {
+public:
+    virtual ~SchreinOfflineStorage() {}
+    virtual uint32_t capacity() const = 0;
+    virtual uint32_t pageSize() const = 0;
+    virtual bool read(uint32_t address, uint8_t *buffer, size_t length) = 0;
+    virtual bool write(uint32_t address, const uint8_t *data, size_t length) = 0;
+    virtual bool erase(uint32_t page) = 0;
+};
+
+// Stockage en RAM sur un tampon fourni par l'appelant
+class SchreinRamStorage : public SchreinOfflineStorage {
+public:
+    SchreinRamStorage(uint8_t *buffer, uint32_t size, uint32_t pageSize = 256);
+    
+    uint32_t capacity() const override;
+    uint32_t pageSize() const override;
+    bool read(uint32_t address, uint8_t *buffer, size_t length) override;
+    bool write(uint32_t address, const uint8_t *data, size_t length) override;
+    bool erase(uint32_t page) override;
+
+private:
+    uint8_t *buffer;
+    uint32_t size;
+    uint32_t page;
+};
+
+// File persistante en journal circulaire : chaque message est écrit une seule
+// fois à la suite du précédent (ajout en O(1), usure répartie sur tout le
+// support), puis marqué consommé d'un seul octet après sa délivrance.
+// Un enregistrement ne chevauche jamais deux pages ; entrer dans une page
+// l'efface, après avoir sacrifié les messages en attente qu'elle contenait.
+// Il faut au moins deux pages.
+//
+// Enregistrement : en-tête de 9 octets puis les données
+//   magic (0xA5), état (0xFF en attente, 0x00 consommé), séquence (uint32 LE),
+//   longueur (uint16 LE), CRC-8 des 6 octets séquence + longueur.
+// L'en-tête est écrit après les données : un enregistrement interrompu par
+// une coupure d'alimentation n'est jamais reconnu au redémarrage.
+class SchreinOfflineQueue {
+public:
+    static const uint8_t HEADER_SIZE = 9;
+    
+    SchreinOfflineQueue(SchreinOfflineStorage &storage);
+    
+    // Reconstruit l'état à partir du support (au démarrage) : l'écriture
+    // reprend après l'enregistrement de plus haute séquence, consommé ou non
+    bool begin();
+    void clear();
+    
+    bool push(const uint8_t *data, size_t length);
+    size_t peek(uint8_t *buffer, size_t maxLength);
+    bool pop();
+    
+    // Lecture par morceaux du plus ancien message, sans tampon de sa taille
+    size_t peekLength();
+    size_t peekChunk(size_t offset, uint8_t *buffer, size_t length);
+    
+    bool isEmpty() const;
+    uint32_t getPendingCount() const;
+    uint32_t getDroppedCount() const;
+    size_t getMaxRecordLength() const;
+
+private:
+    SchreinOfflineStorage &storage;
+    uint32_t head;          // Prochain emplacement d'écriture
+    uint32_t headPage;      // Page ouverte en écriture (head peut valoir sa fin)
+    uint32_t tail;          // Plus ancien enregistrement en attente
+    uint32_t pendingCount;
+    uint32_t droppedCount;
+    uint32_t nextSequence;
+    
+    bool readHeader(uint32_t address, uint32_t &sequence, uint16_t &length, bool &pending);
+    bool isErased(uint32_t address, uint32_t end);
+    bool openNextPage();
+    void dropOldest();
+    void advanceTail();
+    static uint8_t crc8(const uint8_t *data, size_t length);
+};
+
+#endif
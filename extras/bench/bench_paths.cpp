@@ -0,0 +1,279 @@
+// Banc de mesure des chemins d'émission et de réception sur le shim hôte.
+//
+// Deux séries, écrites en JSON sur la sortie standard :
+//   "cpu"     : port idéal (débit infini, module instantané). Temps CPU réel
+//               par message, allocations du tas (String à la manière du cœur
+//               Arduino) et pic de RAM (objet + tas).
+//   "latency" : port à débit fini et module à latence injectée, en temps
+//               virtuel. Latence de bout en bout (appel -> dernier octet sur
+//               le fil, premier octet émis par le pair -> callback, commande
+//               AT -> réponse) en percentiles, et messages délivrés.
+// L'émission est modélisée par un tampon sans limite vidé au débit série.
+
+#include <SchreinBluetoothManager.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Port série simulé : débit fini, réponse "OK" du module après chaque ligne
+class BenchStream : public Stream {
+public:
+    unsigned long baud = 0;              // 0 = débit infini
+    long atLatencyMicros = -1;           // >= 0 : le module répond "OK" à chaque ligne
+    unsigned long txFreeAt = 0;          // Fin d'émission du dernier octet écrit (µs)
+    unsigned long rxFreeAt = 0;
+    unsigned long txLines = 0;
+
+    void scheduleRx(const std::string &data, unsigned long at) {
+        unsigned long time = std::max(at, rxFreeAt);
+        for (size_t i = 0; i < data.size(); i++) {
+            time += byteMicros();
+            rx.push_back(Byte { time, data[i] });
+        }
+        rxFreeAt = time;
+    }
+
+    int available() override {
+        if (rx.empty()) return 0;
+        // Octets en vol : l'attente active de la bibliothèque dure jusqu'à leur arrivée
+        if (rx.front().time > SchreinHost::nowMicros) SchreinHost::nowMicros = rx.front().time;
+        Byte limit { SchreinHost::nowMicros, 0 };
+        return (int)(std::upper_bound(rx.begin(), rx.end(), limit, arrivesBefore) - rx.begin());
+    }
+
+    int read() override {
+        if (!available()) return -1;
+        int c = (uint8_t)rx.front().value;
+        rx.pop_front();
+        return c;
+    }
+
+    int peek() override {
+        return available() ? (uint8_t)rx.front().value : -1;
+    }
+
+    size_t write(uint8_t c) override {
+        txFreeAt = std::max(SchreinHost::nowMicros, txFreeAt) + byteMicros();
+        if (c == '\n') {
+            txLines++;
+            if (atLatencyMicros >= 0) scheduleRx("OK\r\n", txFreeAt + (unsigned long)atLatencyMicros);
+        }
+        return 1;
+    }
+    using Print::write;
+
+private:
+    struct Byte {
+        unsigned long time;
+        char value;
+    };
+    std::deque<Byte> rx;
+
+    unsigned long byteMicros() const { return baud ? 10000000UL / baud : 0; }
+    static bool arrivesBefore(const Byte &a, const Byte &b) { return a.time < b.time; }
+};
+
+enum Path { SEND_STRING, SEND_BYTES, SEND_WITH_RETRY, RECEIVE, AT_COMMAND };
+static const char *const pathNames[] = {
+    "sendRawData", "sendRawBytes", "sendRawDataWithRetry", "receive", "sendATCommand"
+};
+
+static const size_t payloadSizes[] = { 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+static const unsigned long baudRates[] = { 9600, 38400, 115200 };
+static const unsigned long messageRates[] = { 1, 10, 100, 1000 };
+static const unsigned long atLatencies[] = { 0, 10, 100 };
+static const unsigned int cpuIterations = 1000;
+static const unsigned int latencyMessages = 100;
+
+// Réception : octets de données reçus et instant du dernier callback
+static unsigned long receivedBytes = 0;
+static unsigned long lastReceiveMicros = 0;
+
+static void onReceive(String data) {
+    receivedBytes += data.length();
+    lastReceiveMicros = SchreinHost::nowMicros;
+}
+
+static void connect(SchreinBluetoothManager &manager, BenchStream &link) {
+    manager.onDataReceived(onReceive);
+    link.scheduleRx("CONNECTED\r\n", SchreinHost::nowMicros);
+    manager.loop();
+}
+
+// Une opération du chemin ; renvoie false si le message n'a pas été émis
+static bool runOnce(Path path, SchreinBluetoothManager &manager, BenchStream &link,
+                    const String &message, const std::string &payload) {
+    switch (path) {
+    case SEND_STRING:
+        return manager.sendRawData(message);
+    case SEND_BYTES:
+        return manager.sendRawData((const uint8_t *)payload.data(), payload.size());
+    case SEND_WITH_RETRY: {
+        unsigned long lines = link.txLines;
+        if (!manager.sendRawDataWithRetry(message)) return false;
+        SchreinHost::advance(manager.getRetryConfig().sendRetryDelay + 1);
+        manager.loop();
+        return link.txLines > lines;
+    }
+    case RECEIVE:
+        link.scheduleRx(payload + "\r\n", SchreinHost::nowMicros);
+        manager.loop();
+        return true;
+    default:
+        return manager.setPin("1234");
+    }
+}
+
+static void printPercentiles(std::vector<unsigned long> &samples) {
+    std::sort(samples.begin(), samples.end());
+    const unsigned int percentiles[] = { 50, 90, 99 };
+    for (unsigned int i = 0; i < 3; i++) {
+        unsigned long value = 0;
+        if (!samples.empty()) value = samples[(samples.size() - 1) * percentiles[i] / 100];
+        printf(",\"p%u_us\":%lu", percentiles[i], value);
+    }
+    printf(",\"max_us\":%lu", samples.empty() ? 0UL : samples.back());
+}
+
+static void benchCpu(Path path, size_t size, bool first) {
+    std::string payload(size, 'x');
+    String message(payload.c_str());
+    
+    BenchStream link;
+    link.atLatencyMicros = path == AT_COMMAND ? 0 : -1;
+    unsigned long baseline = SchreinHost::heapLiveBytes;
+    SchreinHost::resetCounters();
+    {
+        SchreinBluetoothManager manager(link);
+        connect(manager, link);
+        
+        unsigned long allocations = SchreinHost::heapAllocations;
+        unsigned long bytes = SchreinHost::heapBytes;
+        unsigned int sent = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < cpuIterations; i++) {
+            if (runOnce(path, manager, link, message, payload)) sent++;
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        double nanos = std::chrono::duration<double, std::nano>(end - start).count();
+        
+        printf("%s\n    {\"path\":\"%s\",\"payload_bytes\":%zu,\"messages\":%u,\"sent\":%u", first ? "" : ",",
+               pathNames[path], size, cpuIterations, sent);
+        printf(",\"cpu_ns_per_msg\":%.0f,\"allocs_per_msg\":%.2f,\"alloc_bytes_per_msg\":%.1f",
+               nanos / cpuIterations,
+               (double)(SchreinHost::heapAllocations - allocations) / cpuIterations,
+               (double)(SchreinHost::heapBytes - bytes) / cpuIterations);
+        printf(",\"peak_heap_bytes\":%lu,\"peak_ram_bytes\":%lu}",
+               SchreinHost::heapPeakBytes - baseline,
+               SchreinHost::heapPeakBytes - baseline + (unsigned long)sizeof(SchreinBluetoothManager));
+    }
+}
+
+static void benchLatency(Path path, size_t size, unsigned long baud, unsigned long rate,
+                         unsigned long atLatency, bool first) {
+    std::string payload(size, 'x');
+    String message(payload.c_str());
+    
+    BenchStream link;
+    link.baud = baud;
+    link.atLatencyMicros = path == AT_COMMAND ? (long)atLatency * 1000 : -1;
+    SchreinBluetoothManager manager(link);
+    connect(manager, link);
+    link.txFreeAt = link.rxFreeAt = SchreinHost::nowMicros;
+    
+    std::vector<unsigned long> samples;
+    unsigned long interval = rate ? 1000000UL / rate : 0;
+    unsigned long next = SchreinHost::nowMicros;
+    unsigned int delivered = 0;
+    
+    for (unsigned int i = 0; i < latencyMessages; i++) {
+        // Arrivée du message suivant : laisser tourner loop() jusque-là
+        while (rate && (long)(SchreinHost::nowMicros - next) < 0) {
+            unsigned long idle = std::min(manager.getIdleDuration(), (next - SchreinHost::nowMicros) / 1000 + 1);
+            SchreinHost::advance(idle);
+            manager.loop();
+        }
+        unsigned long start = next = std::max(next, SchreinHost::nowMicros);
+        next += interval;
+        
+        unsigned long lines = link.txLines;
+        receivedBytes = 0;
+        
+        if (path == SEND_STRING) {
+            manager.sendRawData(message);
+        } else if (path == SEND_BYTES) {
+            manager.sendRawData((const uint8_t *)payload.data(), payload.size());
+        } else if (path == SEND_WITH_RETRY) {
+            // Un seul message en attente de retry : le suivant remplace le précédent,
+            // d'où "delivered" < "messages" dès que l'intervalle passe sous sendRetryDelay
+            manager.sendRawDataWithRetry(message);
+            while (link.txLines == lines && manager.isRetrying() &&
+                   (!rate || (long)(SchreinHost::nowMicros - next) < 0)) {
+                SchreinHost::advance(std::max(1UL, std::min(manager.getIdleDuration(), 10UL)));
+                manager.loop();
+            }
+        } else if (path == RECEIVE) {
+            link.scheduleRx(payload + "\r\n", start);
+            while (receivedBytes < size) manager.loop();
+            samples.push_back(lastReceiveMicros - start);
+            delivered++;
+            continue;
+        } else {
+            bool ok = manager.setPin("1234");
+            if (ok) {
+                samples.push_back(SchreinHost::nowMicros - start);
+                delivered++;
+            }
+            continue;
+        }
+        
+        if (link.txLines > lines) {
+            samples.push_back(link.txFreeAt - start);
+            delivered++;
+        }
+    }
+    
+    printf("%s\n    {\"path\":\"%s\",\"payload_bytes\":%zu,\"baud\":%lu,\"rate_hz\":%lu",
+           first ? "" : ",", pathNames[path], size, baud, rate);
+    if (path == AT_COMMAND) printf(",\"module_latency_ms\":%lu", atLatency);
+    printf(",\"messages\":%u,\"delivered\":%u", latencyMessages, delivered);
+    printPercentiles(samples);
+    printf("}");
+}
+
+int main() {
+    SchreinHost::tickMicros = 1;
+    
+    printf("{\n  \"sizeof_manager\":%zu,\n  \"cpu\":[", sizeof(SchreinBluetoothManager));
+    bool first = true;
+    for (int path = SEND_STRING; path <= RECEIVE; path++) {
+        for (size_t size : payloadSizes) {
+            benchCpu((Path)path, size, first);
+            first = false;
+        }
+    }
+    benchCpu(AT_COMMAND, 4, false);
+    
+    printf("\n  ],\n  \"latency\":[");
+    first = true;
+    for (int path = SEND_STRING; path <= RECEIVE; path++) {
+        for (size_t size : payloadSizes) {
+            for (unsigned long baud : baudRates) {
+                for (unsigned long rate : messageRates) {
+                    benchLatency((Path)path, size, baud, rate, 0, first);
+                    first = false;
+                }
+            }
+        }
+    }
+    for (unsigned long baud : baudRates) {
+        for (unsigned long latency : atLatencies) {
+            benchLatency(AT_COMMAND, 4, baud, 0, latency, false);
+        }
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Rejeu d'une capture du lien série (dumpCapture(), format SBMC) dans un
+// gestionnaire sur le shim hôte, pour reproduire une session de terrain.
+//
+//   replay_capture <capture> [vitesse]
+//
+// vitesse : 0 = sans attente (défaut), N = N fois le rythme d'origine en
+// temps virtuel. Les lignes reçues sont écrites sur la sortie d'erreur,
+// horodatées en ms virtuelles ; un résumé JSON sur la sortie standard
+// (chemin "receive" détaillé si construit avec -DSBM_ENABLE_METRICS=1).
+
+#include <SchreinBluetoothManager.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static unsigned long replayStart = 0;
+static unsigned long linesReceived = 0;
+
+static void printLine(String data) {
+    fprintf(stderr, "+%lu %s\n", millis() - replayStart, data.c_str());
+    linesReceived++;
+}
+
+static bool readFile(const char *path, std::vector<uint8_t> &content) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    uint8_t chunk[4096];
+    size_t length;
+    while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        content.insert(content.end(), chunk, chunk + length);
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <capture> [speed]\n", argv[0]);
+        return 2;
+    }
+    uint16_t speed = argc == 3 ? (uint16_t)strtoul(argv[2], nullptr, 10) : 0;
+
+    std::vector<uint8_t> capture;
+    if (!readFile(argv[1], capture)) {
+        fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    SchreinCaptureReplay stream(capture.data(), capture.size(), speed);
+    if (!stream.isValid()) {
+        fprintf(stderr, "%s: %s is not an SBMC v%u capture\n", argv[0], argv[1],
+                SchreinLinkCapture::FORMAT_VERSION);
+        return 1;
+    }
+
+    SchreinBluetoothManager manager(stream);
+    manager.onDataReceived(printLine);
+
+    // Une fois la dernière ligne délivrée, plus rien à attendre
+    replayStart = millis();
+    unsigned long loops = 0;
+    std::chrono::steady_clock::time_point cpuStart = std::chrono::steady_clock::now();
+    while (!stream.isFinished()) {
+        manager.loop();
+        loops++;
+        if (speed > 0) SchreinHost::advance(1);
+    }
+    manager.loop();
+    double cpuNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - cpuStart).count();
+
+    printf("{\"capture\":\"%s\",\"capture_bytes\":%zu,\"speed\":%u", argv[1], capture.size(), speed);
+    printf(",\"rx_bytes\":%lu,\"tx_bytes\":%lu,\"lines\":%lu", stream.getBytesReplayed(),
+           stream.getBytesWritten(), linesReceived);
+    printf(",\"loops\":%lu,\"virtual_ms\":%lu,\"cpu_ns_per_line\":%.0f", loops, millis() - replayStart,
+           linesReceived > 0 ? cpuNanos / linesReceived : 0.0);
+#if SBM_ENABLE_METRICS
+    const SchreinBluetoothManager::PathMetrics &receive = manager.getMetrics().receive;
+    printf(",\"receive\":{\"calls\":%lu,\"bytes\":%lu,\"total_us\":%lu,\"max_us\":%lu}",
+           receive.calls, receive.bytes, receive.totalMicros, receive.maxMicros);
+#endif
+    printf("}\n");
+    return 0;
+}
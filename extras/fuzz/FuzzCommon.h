@@ -0,0 +1,35 @@
+#ifndef SCHREIN_FUZZ_COMMON_H
+#define SCHREIN_FUZZ_COMMON_H
+
+#include <SchreinBluetoothManager.h>
+#include <HostStream.h>
+#include <stdio.h>
+
+// Vérification active même en build optimisé (NDEBUG)
+#define SBM_FUZZ_ASSERT(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: invariant violated: %s\n", __FILE__, __LINE__, #condition); \
+        abort(); \
+    } \
+} while (0)
+
+// Bornes attendues des parseurs : aucune String plus longue qu'une ligne
+// (plus le préfixe d'un message d'erreur), travail linéaire en octets reçus
+#define SBM_FUZZ_MAX_STRING (SBM_MAX_LINE_LENGTH + 64)
+#define SBM_FUZZ_WORK_PER_BYTE 64UL
+#define SBM_FUZZ_WORK_BASE 4096UL
+
+inline void checkManager(const SchreinBluetoothManager &manager, size_t bytesFed) {
+    SBM_FUZZ_ASSERT(manager.checkInvariants());
+    SBM_FUZZ_ASSERT(SchreinHost::stringPeakLength <= SBM_FUZZ_MAX_STRING);
+    SBM_FUZZ_ASSERT(SchreinHost::stringWork <= SBM_FUZZ_WORK_BASE + SBM_FUZZ_WORK_PER_BYTE * bytesFed);
+}
+
+// Source d'aléa déterministe : une entrée rejouée suit le même chemin
+inline void fuzzRandom(uint8_t *buffer, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = (uint8_t)random(256);
+    }
+}
+
+#endif
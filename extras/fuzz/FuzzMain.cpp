@@ -0,0 +1,124 @@
+// Pilote autonome des cibles de fuzzing, pour les compilateurs sans
+// libFuzzer (gcc, afl-g++) :
+//   cible <fichier|répertoire>...   rejoue les entrées (corpus de régression)
+//   cible -runs=N <corpus>...       rejoue puis mute le corpus N fois
+//   cible                            lit une entrée sur stdin (AFL)
+// Une entrée qui fait échouer une assertion est écrite dans ./crash-input.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static const std::vector<uint8_t> *currentInput = nullptr;
+
+// abort() d'une assertion : conserver l'entrée fautive pour la rejouer
+static void saveCurrentInput(int signal) {
+    if (currentInput) {
+        FILE *file = fopen("crash-input", "wb");
+        if (file) {
+            fwrite(currentInput->data(), 1, currentInput->size(), file);
+            fclose(file);
+            fprintf(stderr, "input written to crash-input (%zu bytes)\n", currentInput->size());
+        }
+    }
+    ::signal(signal, SIG_DFL);
+    raise(signal);
+}
+
+static void runInput(const std::vector<uint8_t> &input) {
+    currentInput = &input;
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+    currentInput = nullptr;
+}
+
+static bool readFile(const std::string &path, std::vector<uint8_t> &content) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    content.clear();
+    uint8_t buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.insert(content.end(), buffer, buffer + length);
+    }
+    fclose(file);
+    return true;
+}
+
+static void collect(const std::string &path, std::vector<std::string> &files) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return;
+    if (!S_ISDIR(info.st_mode)) {
+        files.push_back(path);
+        return;
+    }
+    DIR *dir = opendir(path.c_str());
+    if (!dir) return;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') collect(path + "/" + entry->d_name, files);
+    }
+    closedir(dir);
+}
+
+static void mutate(std::vector<uint8_t> &input, uint32_t &state) {
+    unsigned int edits = 1 + (state >> 28);
+    for (unsigned int i = 0; i < edits; i++) {
+        state = state * 1664525UL + 1013904223UL;
+        size_t position = input.empty() ? 0 : (state >> 8) % input.size();
+        switch ((state >> 4) & 3) {
+        case 0: if (!input.empty()) input[position] ^= (uint8_t)(1 << (state & 7)); break;
+        case 1: input.insert(input.begin() + position, (uint8_t)(state >> 16)); break;
+        case 2: if (!input.empty()) input.erase(input.begin() + position); break;
+        default: {
+            // Répéter une portion : lignes dupliquées, trames rejouées
+            std::vector<uint8_t> slice(input.begin() + position,
+                                       input.begin() + position + (input.size() - position) / 2);
+            if (input.size() + slice.size() <= 16384) input.insert(input.begin() + position, slice.begin(), slice.end());
+            break;
+        }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned long runs = 0;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) runs = strtoul(argv[i] + 6, nullptr, 10);
+        else collect(argv[i], files);
+    }
+    
+    signal(SIGABRT, saveCurrentInput);
+    
+    std::vector<uint8_t> input;
+    if (files.empty()) {
+        readFile("/dev/stdin", input);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+        return 0;
+    }
+    
+    std::vector<std::vector<uint8_t> > corpus;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!readFile(files[i], input)) continue;
+        runInput(input);
+        corpus.push_back(input);
+    }
+    printf("%s: %zu corpus inputs passed\n", argv[0], corpus.size());
+    
+    uint32_t state = 0x5EED;
+    for (unsigned long run = 0; run < runs && !corpus.empty(); run++) {
+        state = state * 1664525UL + 1013904223UL;
+        input = corpus[state % corpus.size()];
+        mutate(input, state);
+        runInput(input);
+    }
+    if (runs) printf("%s: %lu mutated inputs passed\n", argv[0], runs);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Fuzzing des parseurs RX : réponses AT, URC de connexion, découpage des
+// lignes, trames de canal, de transfert en masse et de session sécurisée.
+//
+// Octet 0 : options
+//   bit 0    mode serveur (URC "CONNECTED:<adresse>" -> parseMacAddress)
+//   bit 1    refreshModuleInfo() d'abord (readATResponse, parseMacAddress)
+//   bit 2    récepteur de transfert en masse
+//   bit 3    session sécurisée
+//   bits 4-6 taille des tranches injectées entre deux loop() (1 << n octets)
+// Octets suivants : flux reçu du module.
+
+#include "FuzzCommon.h"
+
+static const uint8_t fuzzKey[SchreinChaChaPoly::KEY_SIZE] = { 0x5B };
+
+static bool bulkWriter(uint32_t offset, const uint8_t *data, size_t length) {
+    (void)data;
+    return offset + length <= 4096;
+}
+
+static void ignoreData(String data) {
+    (void)data;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size == 0) return 0;
+    
+    uint8_t options = data[0];
+    data++;
+    size--;
+    
+    randomSeed(1);
+    SchreinHost::resetCounters();
+    
+    HostStream link;
+    SchreinBluetoothManager manager(link, (options & 0x01) ? SchreinBluetoothManager::Mode::SERVER
+                                                           : SchreinBluetoothManager::Mode::CLIENT);
+    manager.onDataReceived(ignoreData);
+    manager.onError(ignoreData);
+    manager.openChannel(0, 1);
+    manager.openChannel(1, 3);
+    manager.onChannelData(1, ignoreData);
+    if (options & 0x04) manager.onBulkDataReceived(bulkWriter);
+    if (options & 0x08) {
+        manager.setRandomSource(fuzzRandom);
+        manager.enableSecureSession(fuzzKey, false);
+    }
+    
+    size_t chunk = (size_t)1 << ((options >> 4) & 0x07);
+    size_t fed = 0;
+    
+    if (options & 0x02) {
+        link.inject(data, size);
+        fed = size;
+        manager.refreshModuleInfo(200);
+        checkManager(manager, fed);
+    }
+    
+    while (fed < size) {
+        size_t length = size - fed < chunk ? size - fed : chunk;
+        link.inject(data + fed, length);
+        fed += length;
+        
+        manager.loop();
+        checkManager(manager, fed);
+    }
+    
+    // Laisser expirer les délais en cours (ACK, poignée de main, retry)
+    for (uint8_t i = 0; i < 4; i++) {
+        SchreinHost::advance(1000);
+        manager.loop();
+        checkManager(manager, fed);
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+// Fuzzing de la machine à états de connexion : chaque octet est une
+// opération (API publique, URC du module, écoulement du temps), suivie de
+// la vérification des invariants (état atteint par la dernière transition
+// acceptée, files et contextes cohérents).
+
+#include "FuzzCommon.h"
+
+static const char *const fuzzAddress = "98:D3:31:FB:12:34";
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    randomSeed(1);
+    SchreinHost::resetCounters();
+    
+    HostStream link;
+    SchreinBluetoothManager manager(link, SchreinBluetoothManager::Mode::CLIENT);
+    
+    SchreinBluetoothManager::RetryConfig config;
+    config.maxConnectionRetries = 2;
+    config.maxATRetries = 1;
+    config.connectionRetryDelay = 50;
+    config.atRetryDelay = 10;
+    manager.configureRetry(config);
+    
+    for (size_t i = 0; i < size; i++) {
+        uint8_t op = data[i] & 0x0F;
+        uint8_t arg = data[i] >> 4;
+        
+        switch (op) {
+        case 0: manager.connect(fuzzAddress); break;
+        case 1:
+            if (arg & 1) link.inject("CONNECTED\r\n");
+            manager.forceConnect(fuzzAddress, true);
+            break;
+        case 2: manager.disconnect(); break;
+        case 3: link.inject((arg & 1) ? "+CONNECTED:98D3:31:FB1234\r\n" : "CONNECTED\r\n"); break;
+        case 4: link.inject("DISCONNECTED\r\n"); break;
+        case 5: link.inject("ERROR\r\n"); break;
+        case 6: SchreinHost::advance((unsigned long)arg * 700); break;
+        case 7: manager.enableRetry(arg & 1); break;
+        case 8: manager.disableRetry(); break;
+        case 9:
+            manager.setMode((arg & 1) ? SchreinBluetoothManager::Mode::SERVER
+                                      : SchreinBluetoothManager::Mode::CLIENT);
+            break;
+        case 10: manager.begin(); break;
+        case 11: manager.end(); break;
+        case 12: manager.sendRawDataWithRetry("ping"); break;
+        default: manager.loop(); break;
+        }
+        
+        SBM_FUZZ_ASSERT(manager.checkInvariants());
+        SBM_FUZZ_ASSERT(manager.isConnected() ==
+                        (manager.getConnectionState() == SchreinBluetoothManager::ConnectionState::CONNECTED));
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "Arduino.h"
+
+namespace SchreinHost {
+    unsigned long nowMicros = 0;
+    unsigned long tickMicros = 100;
+    size_t stringPeakLength = 0;
+    unsigned long stringWork = 0;
+    unsigned long heapAllocations = 0;
+    unsigned long heapBytes = 0;
+    unsigned long heapLiveBytes = 0;
+    unsigned long heapPeakBytes = 0;
+
+    void advance(unsigned long ms) {
+        nowMicros += ms * 1000UL;
+    }
+
+    void resetCounters() {
+        stringPeakLength = 0;
+        stringWork = 0;
+        heapAllocations = 0;
+        heapBytes = 0;
+        heapPeakBytes = heapLiveBytes;
+    }
+
+    void heapResize(unsigned int &allocated, unsigned int size) {
+        heapLiveBytes = heapLiveBytes - allocated + size;
+        if (size > 0) {
+            heapAllocations++;
+            heapBytes += size;
+        }
+        if (heapLiveBytes > heapPeakBytes) heapPeakBytes = heapLiveBytes;
+        allocated = size;
+    }
+}
+
+static unsigned long randomState = 1;
+
+unsigned long micros() {
+    SchreinHost::nowMicros += SchreinHost::tickMicros;
+    return SchreinHost::nowMicros;
+}
+
+unsigned long millis() {
+    return micros() / 1000UL;
+}
+
+void delay(unsigned long ms) {
+    SchreinHost::advance(ms);
+}
+
+long random(long howbig) {
+    // Générateur déterministe : les entrées de fuzzing restent reproductibles
+    randomState = randomState * 1103515245UL + 12345UL;
+    return howbig > 0 ? (long)((randomState >> 8) % (unsigned long)howbig) : 0;
+}
+
+void randomSeed(unsigned long seed) {
+    randomState = seed;
+}
@@ -0,0 +1,139 @@
+#ifndef SCHREIN_HOST_ARDUINO_H
+#define SCHREIN_HOST_ARDUINO_H
+
+// Sous-ensemble de l'API Arduino pour compiler la bibliothèque sur l'hôte
+// (fuzzing, tests, benchmark). Horloge virtuelle : chaque appel à millis()
+// ou micros() avance de SchreinHost::tickMicros, si bien que les attentes
+// actives de la bibliothèque se terminent sans délai réel.
+//
+// String compte ses allocations comme le cœur Arduino : un tampon de la
+// taille exacte (plus le zéro final) dès la construction, réalloué à chaque
+// dépassement, sans optimisation des petites chaînes.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <string>
+#include <type_traits>
+
+namespace SchreinHost {
+    extern unsigned long nowMicros;     // Horloge virtuelle
+    extern unsigned long tickMicros;    // Avance à chaque lecture de l'horloge
+    extern size_t stringPeakLength;     // Plus longue String observée
+    extern unsigned long stringWork;    // Octets copiés par les String
+    extern unsigned long heapAllocations;  // malloc/realloc des String
+    extern unsigned long heapBytes;        // Octets demandés au total
+    extern unsigned long heapLiveBytes;    // Octets alloués en ce moment
+    extern unsigned long heapPeakBytes;    // Maximum de heapLiveBytes
+    void advance(unsigned long ms);
+    void resetCounters();
+    void heapResize(unsigned int &allocated, unsigned int size);
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+long random(long howbig);
+void randomSeed(unsigned long seed);
+
+template <class T, class U>
+typename std::common_type<T, U>::type min(T a, U b) { return a < b ? a : b; }
+
+class String {
+public:
+    String(const char *text = "") : s(text ? text : "") { note(); }
+    String(const std::string &text) : s(text) { note(); }
+    String(const String &other) : s(other.s) { note(); }
+    explicit String(char c) : s(1, c) { note(); }
+    String(int value) : s(std::to_string(value)) { note(); }
+    String(unsigned int value) : s(std::to_string(value)) { note(); }
+    String(long value) : s(std::to_string(value)) { note(); }
+    String(unsigned long value) : s(std::to_string(value)) { note(); }
+    String(unsigned char value) : s(std::to_string(value)) { note(); }
+    ~String() { SchreinHost::heapResize(allocated, 0); }
+    String &operator=(const String &other) { s = other.s; note(); return *this; }
+
+    unsigned int length() const { return s.size(); }
+    const char *c_str() const { return s.c_str(); }
+    char operator[](unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    bool reserve(unsigned int size) {
+        if (size + 1 > allocated) SchreinHost::heapResize(allocated, size + 1);
+        return true;
+    }
+    long toInt() const { return atol(s.c_str()); }
+
+    String &operator+=(const String &other) { s += other.s; note(other.s.size()); return *this; }
+    String &operator+=(const char *text) { s += text; note(strlen(text)); return *this; }
+    String &operator+=(char c) { s += c; note(1); return *this; }
+
+    bool operator==(const String &other) const { return s == other.s; }
+    bool operator!=(const String &other) const { return s != other.s; }
+    bool operator==(const char *text) const { return s == text; }
+    bool operator!=(const char *text) const { return s != text; }
+
+    bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String &suffix) const {
+        return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const { return position(s.find(c, from)); }
+    int indexOf(const String &text, unsigned int from = 0) const { return position(s.find(text.s, from)); }
+    String substring(unsigned int from, unsigned int to = UINT_MAX) const {
+        if (from >= s.size() || to <= from) return String();
+        return String(s.substr(from, to - from));
+    }
+    void trim() {
+        size_t first = s.find_first_not_of(" \t\r\n");
+        size_t last = s.find_last_not_of(" \t\r\n");
+        s = first == std::string::npos ? std::string() : s.substr(first, last - first + 1);
+        note();
+    }
+    void replace(const String &from, const String &to) {
+        for (size_t p = 0; !from.s.empty() && (p = s.find(from.s, p)) != std::string::npos; p += to.s.size()) {
+            s.replace(p, from.s.size(), to.s);
+        }
+        note();
+    }
+    void remove(unsigned int index, unsigned int count) { s.erase(index, count); note(); }
+
+private:
+    std::string s;
+    unsigned int allocated = 0;         // Tampon Arduino émulé, zéro final compris
+    void note(size_t copied = SIZE_MAX) {
+        SchreinHost::stringWork += copied == SIZE_MAX ? s.size() : copied;
+        if (s.size() > SchreinHost::stringPeakLength) SchreinHost::stringPeakLength = s.size();
+        if (s.size() + 1 > allocated) SchreinHost::heapResize(allocated, s.size() + 1);
+    }
+    static int position(size_t found) { return found == std::string::npos ? -1 : (int)found; }
+};
+
+inline String operator+(const String &a, const String &b) { String r(a); r += b; return r; }
+inline String operator+(const String &a, const char *b) { String r(a); r += b; return r; }
+inline String operator+(const char *a, const String &b) { String r(a); r += b; return r; }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t length) {
+        size_t written = 0;
+        while (length--) written += write(*buffer++);
+        return written;
+    }
+    virtual void flush() {}
+    size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+    size_t print(const String &text) { return write((const uint8_t *)text.c_str(), text.length()); }
+    size_t println() { return print("\r\n"); }
+    size_t println(const char *text) { return print(text) + println(); }
+    size_t println(const String &text) { return print(text) + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+#endif
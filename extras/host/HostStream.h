@@ -0,0 +1,28 @@
+#ifndef SCHREIN_HOST_STREAM_H
+#define SCHREIN_HOST_STREAM_H
+
+#include <Arduino.h>
+#include <string>
+
+// Port série simulé : "rx" est ce que le module envoie, "tx" ce qu'il reçoit
+class HostStream : public Stream {
+public:
+    std::string rx;
+    std::string tx;
+    size_t rxPosition = 0;
+
+    void inject(const std::string &data) { rx.append(data); }
+    void inject(const uint8_t *data, size_t length) { rx.append((const char *)data, length); }
+
+    int available() override { return (int)(rx.size() - rxPosition); }
+    int read() override { return rxPosition < rx.size() ? (uint8_t)rx[rxPosition++] : -1; }
+    int peek() override { return rxPosition < rx.size() ? (uint8_t)rx[rxPosition] : -1; }
+    size_t write(uint8_t c) override { tx.push_back((char)c); return 1; }
+    size_t write(const uint8_t *buffer, size_t length) override {
+        tx.append((const char *)buffer, length);
+        return length;
+    }
+    using Print::write;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef SCHREIN_TEST_COMMON_H
+#define SCHREIN_TEST_COMMON_H
+
+#include <SchreinBluetoothManager.h>
+#include <HostStream.h>
+#include <stdio.h>
+
+// Vérification active même en build optimisé (NDEBUG)
+#define SBM_TEST_ASSERT(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+        abort(); \
+    } \
+} while (0)
+
+#endif
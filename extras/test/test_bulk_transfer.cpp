@@ -0,0 +1,184 @@
+// Régression du transfert en masse entre deux gestionnaires reliés : reprise
+// après coupure, contenu différent de même taille, "$CRC:OK" perdu.
+
+#include "TestCommon.h"
+#include <string>
+#include <vector>
+
+static std::string sentContent;
+static std::string receivedContent;
+static std::vector<uint32_t> writeOffsets;
+static int senderDone = 0;
+static bool senderSuccess = false;
+static int receiverDone = 0;
+static bool receiverSuccess = false;
+
+static size_t readContent(uint32_t offset, uint8_t *buffer, size_t length) {
+    if (offset >= sentContent.size()) return 0;
+    if (length > sentContent.size() - offset) length = sentContent.size() - offset;
+    memcpy(buffer, sentContent.data() + offset, length);
+    return length;
+}
+
+static bool writeContent(uint32_t offset, const uint8_t *data, size_t length) {
+    if (receivedContent.size() < offset + length) receivedContent.resize(offset + length);
+    memcpy(&receivedContent[offset], data, length);
+    writeOffsets.push_back(offset);
+    return true;
+}
+
+static void onSenderComplete(bool success, uint32_t) {
+    senderDone++;
+    senderSuccess = success;
+}
+
+static void onReceiverComplete(bool success, uint32_t) {
+    receiverDone++;
+    receiverSuccess = success;
+}
+
+static std::string pattern(size_t size, uint8_t seed) {
+    std::string content(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        content[i] = (char)(i * 31 + seed);
+    }
+    return content;
+}
+
+struct BulkLink {
+    HostStream aStream;
+    HostStream bStream;
+    SchreinBluetoothManager a;          // Émetteur
+    SchreinBluetoothManager b;          // Récepteur
+    bool linked = false;
+    unsigned int dropCrcOk = 0;         // "$CRC:OK" de B à perdre
+
+    BulkLink() : a(aStream), b(bStream) {
+        a.onBulkTransferComplete(onSenderComplete);
+        b.onBulkDataReceived(writeContent);
+        b.onBulkReceiveComplete(onReceiverComplete);
+        senderDone = receiverDone = 0;
+        receivedContent.clear();
+        writeOffsets.clear();
+        connect();
+    }
+
+    void connect() {
+        aStream.inject("CONNECTED\r\n");
+        bStream.inject("CONNECTED\r\n");
+        linked = true;
+    }
+
+    // Coupure : les lignes en vol sont perdues
+    void disconnect() {
+        linked = false;
+        aStream.tx.clear();
+        bStream.tx.clear();
+        aStream.inject("DISCONNECTED\r\n");
+        bStream.inject("DISCONNECTED\r\n");
+        step();
+    }
+
+    static std::vector<std::string> takeLines(HostStream &stream) {
+        std::vector<std::string> lines;
+        size_t start = 0;
+        size_t end;
+        while ((end = stream.tx.find("\r\n", start)) != std::string::npos) {
+            lines.push_back(stream.tx.substr(start, end - start));
+            start = end + 2;
+        }
+        stream.tx.erase(0, start);
+        return lines;
+    }
+
+    void step() {
+        SchreinHost::advance(10);
+        a.loop();
+        b.loop();
+        std::vector<std::string> lines = takeLines(aStream);
+        for (size_t i = 0; i < lines.size() && linked; i++) {
+            bStream.inject(lines[i] + "\r\n");
+        }
+        lines = takeLines(bStream);
+        for (size_t i = 0; i < lines.size() && linked; i++) {
+            if (lines[i] == "$CRC:OK" && dropCrcOk > 0) {
+                dropCrcOk--;
+                continue;
+            }
+            aStream.inject(lines[i] + "\r\n");
+        }
+    }
+
+    bool runUntil(bool (*condition)()) {
+        for (int i = 0; i < 5000; i++) {
+            step();
+            if (condition()) return true;
+        }
+        return false;
+    }
+};
+
+static bool senderFinished() { return senderDone > 0; }
+static bool receivedSome() { return receivedContent.size() >= 5 * SBM_BULK_CHUNK_SIZE; }
+
+// Coupure en plein transfert : reprise à l'offset confirmé, pas depuis 0
+static void testResumeAfterDisconnect() {
+    BulkLink link;
+    sentContent = pattern(20 * SBM_BULK_CHUNK_SIZE + 17, 1);
+    SBM_TEST_ASSERT(link.a.startBulkTransfer(sentContent.size(), readContent));
+    SBM_TEST_ASSERT(link.runUntil(receivedSome));
+    
+    link.disconnect();
+    size_t writesBefore = writeOffsets.size();
+    link.connect();
+    SBM_TEST_ASSERT(link.runUntil(senderFinished));
+    
+    SBM_TEST_ASSERT(senderDone == 1 && senderSuccess);
+    SBM_TEST_ASSERT(receiverDone == 1 && receiverSuccess);
+    SBM_TEST_ASSERT(receivedContent == sentContent);
+    SBM_TEST_ASSERT(writeOffsets.size() > writesBefore && writeOffsets[writesBefore] > 0);
+}
+
+// Même taille, autre contenu : le récepteur ne doit pas reprendre l'ancien
+static void testSameSizeDifferentContent() {
+    BulkLink link;
+    sentContent = pattern(20 * SBM_BULK_CHUNK_SIZE, 2);
+    SBM_TEST_ASSERT(link.a.startBulkTransfer(sentContent.size(), readContent));
+    SBM_TEST_ASSERT(link.runUntil(receivedSome));
+    
+    link.disconnect();
+    link.a.cancelBulkTransfer();
+    sentContent = pattern(sentContent.size(), 3);
+    SBM_TEST_ASSERT(link.a.startBulkTransfer(sentContent.size(), readContent));
+    size_t writesBefore = writeOffsets.size();
+    link.connect();
+    SBM_TEST_ASSERT(link.runUntil(senderFinished));
+    
+    SBM_TEST_ASSERT(writeOffsets.size() > writesBefore && writeOffsets[writesBefore] == 0);
+    SBM_TEST_ASSERT(senderDone == 1 && senderSuccess);
+    SBM_TEST_ASSERT(receiverDone == 1 && receiverSuccess);
+    SBM_TEST_ASSERT(receivedContent == sentContent);
+}
+
+// "$CRC:OK" perdu : l'émetteur réémet END, le récepteur confirme à nouveau
+// sans signaler une seconde réception
+static void testLostCrcOk() {
+    BulkLink link;
+    link.dropCrcOk = 1;
+    sentContent = pattern(3 * SBM_BULK_CHUNK_SIZE + 5, 4);
+    SBM_TEST_ASSERT(link.a.startBulkTransfer(sentContent.size(), readContent));
+    SBM_TEST_ASSERT(link.runUntil(senderFinished));
+    
+    SBM_TEST_ASSERT(link.dropCrcOk == 0);
+    SBM_TEST_ASSERT(senderDone == 1 && senderSuccess);
+    SBM_TEST_ASSERT(receiverDone == 1 && receiverSuccess);
+    SBM_TEST_ASSERT(receivedContent == sentContent);
+}
+
+int main() {
+    testResumeAfterDisconnect();
+    testSameSizeDifferentContent();
+    testLostCrcOk();
+    printf("test_bulk_transfer: passed\n");
+    return 0;
+}
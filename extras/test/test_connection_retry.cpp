@@ -0,0 +1,92 @@
+// Régression du retry de connexion piloté par la table de transitions :
+// un retry que la table refuse ne doit jamais émettre AT+CONN.
+
+#include "TestCommon.h"
+#include <string>
+
+static const char *const address = "98:D3:31:FB:12:34";
+
+static SchreinBluetoothManager::RetryConfig fastRetry() {
+    SchreinBluetoothManager::RetryConfig config;
+    config.maxConnectionRetries = 3;
+    config.connectionRetryDelay = 50;
+    return config;
+}
+
+static bool traceContains(SchreinBluetoothManager &manager, SchreinBluetoothManager::ConnectionEvent event,
+                          bool accepted) {
+    SchreinBluetoothManager::TransitionTraceEntry entry;
+    for (uint8_t i = 0; manager.getTransitionTraceEntry(i, entry); i++) {
+        if (entry.event == (uint8_t)event && entry.accepted == accepted) return true;
+    }
+    return false;
+}
+
+// connect(), URC ERROR, puis échéance du retry : la tentative est annulée
+static void testErrorCancelsRetry() {
+    HostStream link;
+    SchreinBluetoothManager manager(link, SchreinBluetoothManager::Mode::CLIENT);
+    manager.configureRetry(fastRetry());
+    
+    SBM_TEST_ASSERT(manager.connect(address));
+    SBM_TEST_ASSERT(manager.getConnectionState() == SchreinBluetoothManager::ConnectionState::RETRY_PENDING);
+    
+    link.inject("ERROR\r\n");
+    manager.loop();
+    SBM_TEST_ASSERT(manager.getConnectionState() == SchreinBluetoothManager::ConnectionState::ERROR);
+    SBM_TEST_ASSERT(!manager.isRetrying());
+    SBM_TEST_ASSERT(manager.checkInvariants());
+    
+    unsigned long start = millis();
+    SchreinHost::advance(500);
+    manager.loop();
+    SBM_TEST_ASSERT(link.tx.find("AT+CONN") == std::string::npos);
+    SBM_TEST_ASSERT(millis() - start < 1000);
+    SBM_TEST_ASSERT(manager.getConnectionState() == SchreinBluetoothManager::ConnectionState::ERROR);
+    SBM_TEST_ASSERT(!traceContains(manager, SchreinBluetoothManager::ConnectionEvent::RETRY_DUE, false));
+    SBM_TEST_ASSERT(manager.checkInvariants());
+}
+
+// Second connect() pendant l'attente : le retry est reprogrammé, pas perdu
+static void testReconnectWhilePending() {
+    HostStream link;
+    SchreinBluetoothManager manager(link, SchreinBluetoothManager::Mode::CLIENT);
+    manager.configureRetry(fastRetry());
+    
+    SBM_TEST_ASSERT(manager.connect(address));
+    SBM_TEST_ASSERT(manager.connect(address));
+    SBM_TEST_ASSERT(manager.getConnectionState() == SchreinBluetoothManager::ConnectionState::RETRY_PENDING);
+    SBM_TEST_ASSERT(manager.isRetrying());
+    
+    // La tentative part, le module répond : connecté
+    SchreinHost::advance(100);
+    link.inject("CONNECTED\r\n");
+    manager.loop();
+    SBM_TEST_ASSERT(link.tx.find("AT+CONN=98,D3,31,FB,12,34") != std::string::npos);
+    SBM_TEST_ASSERT(manager.isConnected());
+    SBM_TEST_ASSERT(manager.checkInvariants());
+}
+
+// disableRetry() pendant l'attente : plus de RETRY_PENDING sans retry
+static void testDisableWhilePending() {
+    HostStream link;
+    SchreinBluetoothManager manager(link, SchreinBluetoothManager::Mode::CLIENT);
+    manager.configureRetry(fastRetry());
+    
+    SBM_TEST_ASSERT(manager.connect(address));
+    manager.disableRetry();
+    SBM_TEST_ASSERT(manager.getConnectionState() == SchreinBluetoothManager::ConnectionState::DISCONNECTED);
+    SBM_TEST_ASSERT(manager.checkInvariants());
+    
+    SchreinHost::advance(500);
+    manager.loop();
+    SBM_TEST_ASSERT(link.tx.find("AT+CONN") == std::string::npos);
+}
+
+int main() {
+    testErrorCancelsRetry();
+    testReconnectWhilePending();
+    testDisableWhilePending();
+    printf("test_connection_retry: passed\n");
+    return 0;
+}
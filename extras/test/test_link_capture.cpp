@@ -0,0 +1,157 @@
+// Capture du lien série et rejeu : le tampon circulaire déborde, la
+// capture vidée est rejouée dans un second gestionnaire qui doit recevoir
+// les mêmes lignes, sans attente (vitesse 0) ou au rythme d'origine (1).
+// Construit avec -DSBM_CAPTURE_SIZE (Makefile) ; écrit aussi la capture
+// dans build/link_capture.sbmc pour "make replay".
+
+#include "TestCommon.h"
+#include <string>
+#include <vector>
+
+#if SBM_CAPTURE_SIZE == 0
+#error "test_link_capture needs -DSBM_CAPTURE_SIZE > 0"
+#endif
+
+static const unsigned int lineCount = 80;
+static const unsigned long linePeriod = 37;
+
+struct ReceivedLine {
+    std::string text;
+    unsigned long time;
+};
+
+static std::vector<ReceivedLine> *received = nullptr;
+
+static void collectLine(String data) {
+    received->push_back(ReceivedLine { data.c_str(), millis() });
+}
+
+static std::string reading(unsigned int index) {
+    return "reading " + std::to_string(index) + " temperature=" + std::to_string(200 + index % 17);
+}
+
+// Gestionnaire capturé : URC, données reçues et quelques émissions
+static std::string captureTraffic(std::vector<ReceivedLine> &original) {
+    HostStream link;
+    SchreinBluetoothManager manager(link);
+    received = &original;
+    manager.onDataReceived(collectLine);
+    SBM_TEST_ASSERT(manager.startCapture());
+
+    link.inject("CONNECTED\r\n");
+    manager.loop();
+    SBM_TEST_ASSERT(manager.isConnected());
+
+    size_t peakSize = 0;
+    for (unsigned int i = 0; i < lineCount; i++) {
+        SchreinHost::advance(linePeriod);
+        link.inject(reading(i) + "\r\n");
+        manager.loop();
+        if (i % 5 == 0) SBM_TEST_ASSERT(manager.sendRawData("ack " + String(i)));
+        if (manager.getCaptureSize() > peakSize) peakSize = manager.getCaptureSize();
+    }
+    manager.stopCapture();
+
+    // Le trafic dépasse le tampon : les plus anciens enregistrements sont partis
+    SBM_TEST_ASSERT(peakSize <= SBM_CAPTURE_SIZE);
+    SBM_TEST_ASSERT(peakSize > SBM_CAPTURE_SIZE - SchreinLinkCapture::MAX_RECORD_LENGTH - 8);
+    SBM_TEST_ASSERT(original.size() == lineCount + 1);
+
+    HostStream dump;
+    manager.dumpCapture(dump);
+    SBM_TEST_ASSERT(dump.tx.size() == manager.getCaptureSize() + 9);
+    SBM_TEST_ASSERT(dump.tx.compare(0, 4, "SBMC") == 0);
+    received = nullptr;
+    return dump.tx;
+}
+
+// Rejoue la capture jusqu'à épuisement ; rend la durée en ms
+static unsigned long replay(const std::string &capture, uint16_t speed, std::vector<ReceivedLine> &lines) {
+    SchreinCaptureReplay stream((const uint8_t *)capture.data(), capture.size(), speed);
+    SBM_TEST_ASSERT(stream.isValid());
+    SchreinBluetoothManager manager(stream);
+    received = &lines;
+    manager.onDataReceived(collectLine);
+
+    unsigned long start = millis();
+    while (!stream.isFinished() && millis() - start < 60000UL) {
+        manager.loop();
+        if (speed > 0) SchreinHost::advance(1);
+    }
+    manager.loop();
+    SBM_TEST_ASSERT(stream.isFinished());
+    SBM_TEST_ASSERT(stream.getBytesReplayed() > 0);
+    received = nullptr;
+    return millis() - start;
+}
+
+// Les lignes rejouées sont la fin des lignes d'origine ; la première peut
+// être tronquée par l'éviction. Rend l'index de la première ligne complète.
+static size_t checkSameLines(const std::vector<ReceivedLine> &original, const std::vector<ReceivedLine> &replayed) {
+    SBM_TEST_ASSERT(replayed.size() >= 2);
+    SBM_TEST_ASSERT(replayed.size() < original.size());
+
+    size_t offset = original.size() - replayed.size();
+    const std::string &first = original[offset].text;
+    const std::string &firstReplayed = replayed[0].text;
+    SBM_TEST_ASSERT(firstReplayed.size() <= first.size());
+    SBM_TEST_ASSERT(first.compare(first.size() - firstReplayed.size(), firstReplayed.size(), firstReplayed) == 0);
+
+    for (size_t i = 1; i < replayed.size(); i++) {
+        SBM_TEST_ASSERT(replayed[i].text == original[offset + i].text);
+    }
+    return offset;
+}
+
+static void testCaptureReplay() {
+    std::vector<ReceivedLine> original;
+    std::string capture = captureTraffic(original);
+
+    FILE *file = fopen("build/link_capture.sbmc", "wb");
+    if (file) {
+        fwrite(capture.data(), 1, capture.size(), file);
+        fclose(file);
+    }
+
+    // Sans attente : tout est délivré bien avant la durée d'origine
+    std::vector<ReceivedLine> fast;
+    unsigned long fastDuration = replay(capture, 0, fast);
+    size_t offset = checkSameLines(original, fast);
+    unsigned long span = original.back().time - original[offset + 1].time;
+    SBM_TEST_ASSERT(span > 10 * linePeriod);
+    SBM_TEST_ASSERT(fastDuration < span / 2);
+
+    // Vitesse 1 : mêmes lignes, aux mêmes écarts qu'à la capture
+    std::vector<ReceivedLine> timed;
+    unsigned long timedDuration = replay(capture, 1, timed);
+    SBM_TEST_ASSERT(checkSameLines(original, timed) == offset);
+    SBM_TEST_ASSERT(timedDuration >= span);
+    for (size_t i = 2; i < timed.size(); i++) {
+        long replayedGap = (long)(timed[i].time - timed[1].time);
+        long originalGap = (long)(original[offset + i].time - original[offset + 1].time);
+        SBM_TEST_ASSERT(replayedGap >= originalGap - 2 && replayedGap <= originalGap + 2);
+    }
+}
+
+// Une capture tronquée ou d'un autre format n'est pas rejouée
+static void testInvalidCapture() {
+    const uint8_t bad[] = { 'S', 'B', 'M', 'X', 1, 0, 0, 0, 0, 0x00, 0x00, 'A' };
+    SchreinCaptureReplay stream(bad, sizeof(bad), 0);
+    SBM_TEST_ASSERT(!stream.isValid());
+    SBM_TEST_ASSERT(stream.available() == 0);
+    SBM_TEST_ASSERT(stream.isFinished());
+
+    // En-tête valide, enregistrement coupé : rien n'est délivré
+    const uint8_t truncated[] = { 'S', 'B', 'M', 'C', SchreinLinkCapture::FORMAT_VERSION, 0, 0, 0, 0, 0x05, 0x00, 'A' };
+    SchreinCaptureReplay cut(truncated, sizeof(truncated), 0);
+    SBM_TEST_ASSERT(cut.isValid());
+    SBM_TEST_ASSERT(cut.read() == -1);
+    SBM_TEST_ASSERT(cut.isFinished());
+}
+
+int main() {
+    testCaptureReplay();
+    testInvalidCapture();
+    printf("test_link_capture: passed\n");
+    return 0;
+}
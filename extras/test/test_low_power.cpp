@@ -0,0 +1,142 @@
+// Indicateurs de consommation sur une charge en rapport cyclique : le
+// module dort entre deux sessions et les canaux n'émettent qu'en rafales.
+// Construit aussi avec des files de plus de 255 trames au total (Makefile).
+
+#include "TestCommon.h"
+
+static const unsigned long burstInterval = 500;
+static const unsigned long sessionLength = 2000;
+static const unsigned long cyclePeriod = 10000;
+static const unsigned long samplePeriod = 200;
+
+static SchreinBluetoothManager::LowPowerConfig burstConfig() {
+    SchreinBluetoothManager::LowPowerConfig config;
+    config.enabled = true;
+    config.burstInterval = burstInterval;
+    config.minSleepDuration = 100;
+    config.wakeupDelay = 50;
+    return config;
+}
+
+// Boucle espacée de getIdleDuration(), comme une application qui dort ;
+// au moins un passage, pour traiter les lignes injectées
+static void runUntil(SchreinBluetoothManager &manager, unsigned long deadline) {
+    for (;;) {
+        manager.loop();
+        unsigned long idle = manager.getIdleDuration();
+        long remaining = (long)(deadline - millis());
+        if (remaining <= 0) return;
+        SchreinHost::advance(idle == 0 ? 1 : min(idle, (unsigned long)remaining));
+    }
+}
+
+static uint8_t queuedFrames(SchreinBluetoothManager &manager) {
+    uint8_t total = 0;
+    for (uint8_t i = 0; i < 2; i++) total += manager.getChannelQueueLength(i);
+    return total;
+}
+
+// Sessions de 2 s toutes les 10 s, une mesure toutes les 200 ms
+static void testDutyCycle() {
+    HostStream link;
+    SchreinBluetoothManager manager(link, SchreinBluetoothManager::Mode::CLIENT);
+    SBM_TEST_ASSERT(manager.openChannel(0, 2));
+    SBM_TEST_ASSERT(manager.openChannel(1));
+    manager.configureLowPower(burstConfig());
+    manager.resetPowerStats();
+
+    const unsigned int cycles = 6;
+    unsigned long start = millis();
+    unsigned long sent = 0;
+
+    for (unsigned int cycle = 0; cycle < cycles; cycle++) {
+        unsigned long cycleStart = start + cycle * cyclePeriod;
+        runUntil(manager, cycleStart);
+
+        link.inject("CONNECTED\r\n");
+        runUntil(manager, cycleStart + 1);
+        SBM_TEST_ASSERT(manager.isConnected());
+        SBM_TEST_ASSERT(manager.isModuleAwake());
+
+        for (unsigned long t = 0; t < sessionLength; t += samplePeriod) {
+            runUntil(manager, cycleStart + 1 + t);
+            SBM_TEST_ASSERT(manager.sendOnChannel(sent % 2, "sample" + String(sent)));
+            sent++;
+        }
+
+        // Dernière rafale avant la coupure
+        runUntil(manager, cycleStart + 1 + sessionLength + burstInterval);
+        SBM_TEST_ASSERT(queuedFrames(manager) == 0);
+
+        link.inject("DISCONNECTED\r\n");
+        runUntil(manager, cycleStart + 1 + sessionLength + burstInterval + 1);
+        SBM_TEST_ASSERT(!manager.isConnected());
+        SBM_TEST_ASSERT(manager.checkInvariants());
+    }
+    runUntil(manager, start + cycles * cyclePeriod);
+    SBM_TEST_ASSERT(!manager.isModuleAwake());
+
+    SchreinBluetoothManager::PowerStats stats = manager.getPowerStats();
+    unsigned long elapsed = millis() - start;
+
+    // Chaque trame émise une fois, regroupées par rafales de l'intervalle
+    SBM_TEST_ASSERT(stats.txFrames == sent);
+    SBM_TEST_ASSERT(stats.txBursts >= cycles * (sessionLength / burstInterval));
+    SBM_TEST_ASSERT(stats.txBursts <= cycles * (sessionLength / burstInterval + 1));
+    SBM_TEST_ASSERT(stats.txBursts * 2 <= stats.txFrames);
+
+    // Éveillé pendant les sessions, endormi entre elles
+    SBM_TEST_ASSERT(stats.awakeTime + stats.sleepTime == elapsed);
+    SBM_TEST_ASSERT(stats.awakeTime >= cycles * (sessionLength + burstInterval));
+    SBM_TEST_ASSERT(stats.sleepTime >= cycles * (cyclePeriod - sessionLength - burstInterval) - cyclePeriod);
+    SBM_TEST_ASSERT(stats.wakeups >= cycles - 1 && stats.wakeups <= cycles);
+}
+
+// Une rafale vide toutes les files pleines, même au-delà de 255 trames
+static void testFullBurst() {
+    HostStream link;
+    SchreinBluetoothManager manager(link, SchreinBluetoothManager::Mode::CLIENT);
+    link.inject("CONNECTED\r\n");
+    manager.loop();
+    SBM_TEST_ASSERT(manager.isConnected());
+
+    manager.configureLowPower(burstConfig());
+    manager.resetPowerStats();
+
+    unsigned long total = 0;
+    for (uint8_t i = 0; i < SBM_MAX_CHANNELS; i++) {
+        SBM_TEST_ASSERT(manager.openChannel(i, i % 3 + 1));
+        for (uint8_t j = 0; j < SBM_CHANNEL_QUEUE_SIZE; j++) {
+            SBM_TEST_ASSERT(manager.sendOnChannel(i, String(j)));
+            total++;
+        }
+    }
+
+    manager.loop();
+    SBM_TEST_ASSERT(manager.getPowerStats().txFrames == 0);
+    SBM_TEST_ASSERT(manager.getIdleDuration() > 0);
+
+    SchreinHost::advance(burstInterval);
+    link.tx.clear();
+    manager.loop();
+
+    SchreinBluetoothManager::PowerStats stats = manager.getPowerStats();
+    SBM_TEST_ASSERT(stats.txBursts == 1);
+    SBM_TEST_ASSERT(stats.txFrames == total);
+
+    unsigned long lines = 0;
+    for (size_t pos = link.tx.find("\r\n"); pos != std::string::npos; pos = link.tx.find("\r\n", pos + 2)) {
+        lines++;
+    }
+    SBM_TEST_ASSERT(lines == total);
+    for (uint8_t i = 0; i < SBM_MAX_CHANNELS; i++) {
+        SBM_TEST_ASSERT(manager.getChannelQueueLength(i) == 0);
+    }
+}
+
+int main() {
+    testDutyCycle();
+    testFullBurst();
+    printf("test_low_power: passed\n");
+    return 0;
+}
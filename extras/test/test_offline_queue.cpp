@@ -0,0 +1,201 @@
+// Régression du journal hors connexion sur un support au contrat flash :
+// écriture 1 -> 0 seulement, effacement par page. Toute réécriture sans
+// effacement ou écriture à cheval sur deux pages est comptée comme violation.
+
+#include "TestCommon.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+class FlashStorage : public SchreinOfflineStorage {
+public:
+    std::vector<uint8_t> memory;
+    uint32_t page;
+    unsigned long violations = 0;
+    unsigned long erases = 0;
+
+    // Support neuf jamais effacé : tout à 0x00
+    FlashStorage(uint32_t pages, uint32_t pageSize) : memory(pages * pageSize, 0x00), page(pageSize) {}
+
+    uint32_t capacity() const override { return (uint32_t)memory.size(); }
+    uint32_t pageSize() const override { return page; }
+
+    bool read(uint32_t address, uint8_t *buffer, size_t length) override {
+        if (address + length > memory.size()) return false;
+        memcpy(buffer, &memory[address], length);
+        return true;
+    }
+
+    bool write(uint32_t address, const uint8_t *data, size_t length) override {
+        if (length == 0 || address + length > memory.size()) return false;
+        if (address / page != (address + length - 1) / page) violations++;
+        for (size_t i = 0; i < length; i++) {
+            if ((memory[address + i] & data[i]) != data[i]) violations++;
+            memory[address + i] &= data[i];
+        }
+        return true;
+    }
+
+    bool erase(uint32_t index) override {
+        if ((index + 1) * page > memory.size()) return false;
+        memset(&memory[index * page], 0xFF, page);
+        erases++;
+        return true;
+    }
+};
+
+static std::string peekString(SchreinOfflineQueue &queue) {
+    std::string text(queue.peekLength(), '\0');
+    size_t offset = 0;
+    while (offset < text.size()) {
+        size_t read = queue.peekChunk(offset, (uint8_t *)&text[offset], 7);
+        SBM_TEST_ASSERT(read > 0);
+        offset += read;
+    }
+    return text;
+}
+
+static bool pushString(SchreinOfflineQueue &queue, const std::string &text) {
+    return queue.push((const uint8_t *)text.data(), text.size());
+}
+
+// Tout consommé puis redémarrage : l'écriture reprend après le dernier
+// enregistrement au lieu de réécrire la zone déjà programmée
+static void testResumeAfterConsumed() {
+    FlashStorage flash(4, 64);
+    {
+        SchreinOfflineQueue queue(flash);
+        SBM_TEST_ASSERT(queue.begin());
+        SBM_TEST_ASSERT(pushString(queue, "first") && pushString(queue, "second") && pushString(queue, "third"));
+        SBM_TEST_ASSERT(queue.pop() && queue.pop() && queue.pop() && queue.isEmpty());
+    }
+    
+    // Ni réécriture ni effacement superflu (usure) : la page courante a de la place
+    unsigned long erases = flash.erases;
+    SchreinOfflineQueue queue(flash);
+    SBM_TEST_ASSERT(queue.begin());
+    SBM_TEST_ASSERT(queue.isEmpty());
+    SBM_TEST_ASSERT(pushString(queue, "after reboot"));
+    SBM_TEST_ASSERT(peekString(queue) == "after reboot");
+    SBM_TEST_ASSERT(flash.violations == 0);
+    SBM_TEST_ASSERT(flash.erases == erases);
+}
+
+// Coupure entre les données et l'en-tête : la fin de page est sale, la
+// reprise ouvre la page suivante sans perdre les messages valides
+static void testInterruptedWrite() {
+    FlashStorage flash(4, 64);
+    uint32_t garbage;
+    {
+        SchreinOfflineQueue queue(flash);
+        SBM_TEST_ASSERT(queue.begin());
+        SBM_TEST_ASSERT(pushString(queue, "kept"));
+        garbage = 64 + SchreinOfflineQueue::HEADER_SIZE + 4;
+    }
+    const uint8_t partial[5] = { 'l', 'o', 's', 't', 0 };
+    SBM_TEST_ASSERT(flash.write(garbage, partial, sizeof(partial)));
+    
+    SchreinOfflineQueue queue(flash);
+    SBM_TEST_ASSERT(queue.begin());
+    SBM_TEST_ASSERT(queue.getPendingCount() == 1);
+    SBM_TEST_ASSERT(pushString(queue, "next"));
+    SBM_TEST_ASSERT(peekString(queue) == "kept" && queue.pop());
+    SBM_TEST_ASSERT(peekString(queue) == "next" && queue.pop());
+    SBM_TEST_ASSERT(flash.violations == 0);
+}
+
+// Ajouts et retraits aléatoires avec redémarrages : ordre FIFO conservé, les
+// seules pertes sont les plus anciens messages sacrifiés à l'effacement d'une page
+static void testRandomWorkload() {
+    FlashStorage flash(4, 64);
+    SchreinOfflineQueue *queue = new SchreinOfflineQueue(flash);
+    SBM_TEST_ASSERT(queue->begin());
+    SBM_TEST_ASSERT(queue->getMaxRecordLength() == 64 - SchreinOfflineQueue::HEADER_SIZE);
+    SBM_TEST_ASSERT(!pushString(*queue, std::string(queue->getMaxRecordLength() + 1, 'x')));
+    
+    std::deque<std::string> model;
+    randomSeed(35);
+    for (int step = 0; step < 20000; step++) {
+        long action = random(10);
+        if (action < 6) {
+            std::string text(1 + random(queue->getMaxRecordLength()), (char)('a' + step % 26));
+            uint32_t dropped = queue->getDroppedCount();
+            SBM_TEST_ASSERT(pushString(*queue, text));
+            for (uint32_t i = dropped; i < queue->getDroppedCount(); i++) {
+                model.pop_front();
+            }
+            model.push_back(text);
+        } else if (action < 9) {
+            if (model.empty()) {
+                SBM_TEST_ASSERT(queue->isEmpty());
+                continue;
+            }
+            SBM_TEST_ASSERT(peekString(*queue) == model.front());
+            SBM_TEST_ASSERT(queue->pop());
+            model.pop_front();
+        } else {
+            delete queue;
+            queue = new SchreinOfflineQueue(flash);
+            SBM_TEST_ASSERT(queue->begin());
+        }
+        SBM_TEST_ASSERT(queue->getPendingCount() == model.size());
+    }
+    delete queue;
+    SBM_TEST_ASSERT(flash.violations == 0);
+    SBM_TEST_ASSERT(flash.erases > 100);
+}
+
+// Gestionnaire : vidange par morceaux d'un message de taille maximale ; un
+// message trop grand pour le journal est refusé tant que la file n'est pas
+// vide (ordre FIFO), émis directement ensuite
+static void testManagerDrain() {
+    static uint8_t buffer[4 * 512];
+    SchreinRamStorage storage(buffer, sizeof(buffer), 512);
+    SchreinOfflineQueue queue(storage);
+    SBM_TEST_ASSERT(queue.begin());
+    SBM_TEST_ASSERT(queue.getMaxRecordLength() == SBM_OFFLINE_MAX_RECORD);
+    
+    HostStream link;
+    SchreinBluetoothManager manager(link);
+    manager.setOfflineQueue(&queue);
+    
+    std::string largest(SBM_OFFLINE_MAX_RECORD, 'L');
+    SBM_TEST_ASSERT(manager.sendRawData(String(largest.c_str())));
+    for (int i = 0; i < SBM_OFFLINE_DRAIN_BATCH + 1; i++) {
+        SBM_TEST_ASSERT(manager.sendRawData(String("queued")));
+    }
+    SBM_TEST_ASSERT(link.tx.empty());
+    
+    // Connexion puis un seul lot vidé : il reste un message en file
+    link.inject("CONNECTED\r\n");
+    while (manager.getOfflinePendingCount() == (uint32_t)SBM_OFFLINE_DRAIN_BATCH + 2) {
+        manager.loop();
+    }
+    SBM_TEST_ASSERT(manager.getOfflinePendingCount() == 2);
+    SBM_TEST_ASSERT(link.tx.compare(0, largest.size() + 2, largest + "\r\n") == 0);
+    
+    link.tx.clear();
+    std::string oversized(SBM_OFFLINE_MAX_RECORD + 40, 'O');
+    SBM_TEST_ASSERT(!manager.sendRawData(String(oversized.c_str())));
+    SBM_TEST_ASSERT(link.tx.empty());
+    SBM_TEST_ASSERT(manager.sendRawData(String("behind")));
+    SBM_TEST_ASSERT(manager.getOfflinePendingCount() == 3);
+    
+    // File vidée dans l'ordre, puis plus rien devant le message trop grand
+    while (manager.getOfflinePendingCount() > 0) {
+        manager.loop();
+    }
+    SBM_TEST_ASSERT(link.tx == "queued\r\nqueued\r\nbehind\r\n");
+    link.tx.clear();
+    SBM_TEST_ASSERT(manager.sendRawData(String(oversized.c_str())));
+    SBM_TEST_ASSERT(link.tx == oversized + "\r\n");
+}
+
+int main() {
+    testResumeAfterConsumed();
+    testInterruptedWrite();
+    testRandomWorkload();
+    testManagerDrain();
+    printf("test_offline_queue: passed\n");
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Sessions multi-pairs : les messages mis de côté pour un pair absent
+// partent à sa reconnexion, sans attendre un loop() que rien ne réveille.
+
+#include "TestCommon.h"
+#include <string>
+
+static const char *const peerA = "98:D3:31:FB:12:34";
+static const char *const peerB = "98:D3:31:FB:56:78";
+
+// Le pair B se connecte : la ligne CONNECTED est lue en fin de loop(),
+// après le passage sur sa file ; l'indication d'inactivité doit le voir
+static void testQueuedPeerWakesLoop() {
+    HostStream link;
+    SchreinBluetoothManager manager(link, SchreinBluetoothManager::Mode::SERVER);
+
+    link.inject(std::string("CONNECTED:") + peerA + "\r\n");
+    manager.loop();
+    SBM_TEST_ASSERT(manager.getActivePeerAddress() == peerA);
+
+    for (uint8_t i = 0; i < SBM_PEER_QUEUE_SIZE; i++) {
+        SBM_TEST_ASSERT(manager.sendToPeer(peerB, "pending" + String(i)));
+    }
+    SBM_TEST_ASSERT(manager.getPeerSession(peerB)->count == SBM_PEER_QUEUE_SIZE);
+
+    link.inject("DISCONNECTED\r\n");
+    manager.loop();
+    link.inject(std::string("CONNECTED:") + peerB + "\r\n");
+    manager.loop();
+    link.tx.clear();
+    SBM_TEST_ASSERT(manager.getActivePeerAddress() == peerB);
+    SBM_TEST_ASSERT(manager.getIdleDuration() == 0);
+
+    // Une application qui dort selon l'indication livre tout en quelques ms
+    unsigned long start = millis();
+    while (manager.getPeerSession(peerB)->count > 0 && millis() - start < 60000UL) {
+        SchreinHost::advance(min(manager.getIdleDuration(), 60000UL));
+        manager.loop();
+    }
+    SBM_TEST_ASSERT(millis() - start < 100);
+    for (uint8_t i = 0; i < SBM_PEER_QUEUE_SIZE; i++) {
+        SBM_TEST_ASSERT(link.tx.find(("pending" + String(i)).c_str()) != std::string::npos);
+    }
+    SBM_TEST_ASSERT(manager.getIdleDuration() > 0);
+    SBM_TEST_ASSERT(manager.checkInvariants());
+}
+
+int main() {
+    testQueuedPeerWakesLoop();
+    printf("test_peer_sessions: passed\n");
+    return 0;
+}